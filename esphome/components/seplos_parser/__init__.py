@@ -1,7 +1,20 @@
+import re
+from pathlib import Path
+
+from esphome import pins
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import uart
-from esphome.const import CONF_ID
+import esphome.final_validate as fv
+from esphome.components import http_request, time, uart
+from esphome.const import (
+    CONF_FLOW_CONTROL_PIN,
+    CONF_ID,
+    CONF_RESTORE,
+    CONF_TIME_ID,
+    CONF_TIMEOUT,
+    CONF_UART_ID,
+    CONF_URL,
+)
 
 DEPENDENCIES = ["uart"]
 
@@ -10,11 +23,315 @@ MULTI_CONF = True
 CONF_BMS_COUNT = "bms_count"
 CONF_UPDATE_INTERVAL = "update_interval"
 CONF_SEPLOS_PARSER_ID = "seplos_parser_id"
+CONF_BMS_INDEX = "bms_index"
+CONF_FIELD = "field"
+CONF_PUBLISH_POLICY = "publish_policy"
+CONF_MIN_INTERVAL = "min_interval"
+CONF_DEADBAND = "deadband"
+CONF_RELATIVE_DEADBAND = "relative_deadband"
+CONF_HEARTBEAT = "heartbeat"
+CONF_DEFAULT = "default"
+CONF_FRAMING = "framing"
+CONF_FRAME_GAP = "frame_gap"
+CONF_LOOP_BUDGET = "loop_budget"
+CONF_DIAGNOSTIC = "diagnostic"
+CONF_BANK = "bank"
+CONF_STALE_TIMEOUT = "stale_timeout"
+CONF_STATISTIC = "statistic"
+CONF_UPLINK = "uplink"
+CONF_HTTP_REQUEST_ID = "http_request_id"
+CONF_API_KEY = "api_key"
+CONF_BUFFER_SIZE = "buffer_size"
+CONF_SAMPLE_INTERVAL = "sample_interval"
+CONF_FLUSH_INTERVAL = "flush_interval"
+CONF_JOURNAL = "journal"
+CONF_PARTITION = "partition"
+CONF_CAPTURE = "capture"
+CONF_PRE_TRIGGER = "pre_trigger"
+CONF_POST_TRIGGER = "post_trigger"
+CONF_TRIGGER = "trigger"
+CONF_WEB_SERVER = "web_server"
+CONF_HISTORY = "history"
+CONF_RETENTION = "retention"
+CONF_FIELDS = "fields"
+CONF_MASTER = "master"
+CONF_PIA_INTERVAL = "pia_interval"
+CONF_PIB_INTERVAL = "pib_interval"
+CONF_PIC_INTERVAL = "pic_interval"
+CONF_ALARM_INTERVAL = "alarm_interval"
+CONF_BUS_BUDGET = "bus_budget"
+CONF_RETRIES = "retries"
+CONF_BUSES = "buses"
+CONF_PACKED = "packed"
+
+# Über alle Busse eines Parsers; Adressen 0x01-0x10 je Bus
+MAX_BMS_COUNT = 48
+MAX_BUS_ADDRESSES = 16
 
 seplos_parser_ns = cg.esphome_ns.namespace("seplos_parser")
 
+
+def _load_register_map():
+    # Die Registertabelle existiert nur einmal, in seplos_registers.h
+    header = (Path(__file__).parent / "seplos_registers.h").read_text()
+    sensor_fields, text_fields, alarm_fields = {}, {}, {}
+    for block, target, prefix in (("SEPLOS_PIA_FIELDS", sensor_fields, "SENSOR_"),
+                                  ("SEPLOS_PIB_FIELDS", sensor_fields, "SENSOR_"),
+                                  ("SEPLOS_TEXT_FIELDS", text_fields, "TEXT_"),
+                                  ("SEPLOS_ALARM_BITS", alarm_fields, "ALARM_")):
+        body = header.split(f"#define {block}(F)", 1)[1].split("\n\n", 1)[0]
+        for key, name in re.findall(r"F\((\w+),\s*(\w+)", body):
+            target[name] = getattr(seplos_parser_ns, prefix + key)
+    return sensor_fields, text_fields, alarm_fields
+
+
+SENSOR_FIELDS, TEXT_SENSOR_FIELDS, BINARY_SENSOR_FIELDS = _load_register_map()
+
+# Ein Textsensor je Pack und Block (packed:)
+PACKED_BLOCKS = {
+    "pia": seplos_parser_ns.BLOCK_PIA,
+    "pib": seplos_parser_ns.BLOCK_PIB,
+    "pic": seplos_parser_ns.BLOCK_PIC,
+}
+
+
+def _load_diagnostics():
+    header = (Path(__file__).parent / "seplos_diagnostics.h").read_text()
+    lists = []
+    for block, prefix in (("SEPLOS_DIAGNOSTICS", "DIAG_"), ("SEPLOS_PACK_DIAGNOSTICS", "PACK_DIAG_")):
+        body = header.split(f"#define {block}(F)", 1)[1].split("\n\n", 1)[0]
+        lists.append(
+            {name: getattr(seplos_parser_ns, prefix + key) for key, name in re.findall(r"F\((\w+),\s*(\w+)", body)}
+        )
+    return lists
+
+
+DIAGNOSTIC_SENSORS, PACK_DIAGNOSTIC_SENSORS = _load_diagnostics()
+
+
+def _load_bank_fields():
+    header = (Path(__file__).parent / "seplos_bank.h").read_text()
+    body = header.split("#define SEPLOS_BANK_FIELDS(F)", 1)[1].split("\n\n", 1)[0]
+    return {name: getattr(seplos_parser_ns, "BANK_" + key) for key, name in re.findall(r"F\((\w+),\s*(\w+)", body)}
+
+
+BANK_SENSORS = _load_bank_fields()
+
+
+def _load_statistics():
+    # Gleitende Statistik als "<größe>_<min|max|mean>_<fenster>", dazu die Energiezähler
+    header = (Path(__file__).parent / "seplos_stats.h").read_text()
+
+    def table(block):
+        body = header.split(f"#define {block}(F)", 1)[1].split("\n\n", 1)[0]
+        return re.findall(r"F\((\w+),\s*(\w+)", body)
+
+    statistics = {}
+    for quantity_key, quantity in table("SEPLOS_STAT_QUANTITIES"):
+        for aggregation in ("min", "max", "mean"):
+            for window_key, window in table("SEPLOS_STAT_WINDOWS"):
+                statistics[f"{quantity}_{aggregation}_{window}"] = (
+                    getattr(seplos_parser_ns, "STAT_" + quantity_key),
+                    getattr(seplos_parser_ns, "WINDOW_" + window_key),
+                    getattr(seplos_parser_ns, "AGG_" + aggregation.upper()),
+                )
+    energy = {name: getattr(seplos_parser_ns, "ENERGY_" + key) for key, name in table("SEPLOS_ENERGY_FIELDS")}
+    return statistics, energy
+
+
+STATISTIC_SENSORS, ENERGY_SENSORS = _load_statistics()
+
+
+def _load_cell_analytics():
+    # Werte je Pack unter ihrem Namen, Werte je Zelle als "cell_<n>_<name>"; jeweils (CellField, Zelle)
+    header = (Path(__file__).parent / "seplos_cells.h").read_text()
+    analytics = {}
+    for block in ("SEPLOS_CELL_FIELDS", "SEPLOS_PER_CELL_FIELDS"):
+        body = header.split(f"#define {block}(F)", 1)[1].split("\n\n", 1)[0]
+        for key, name in re.findall(r"F\((\w+),\s*(\w+)", body):
+            field = getattr(seplos_parser_ns, "ANALYTICS_" + key)
+            if block == "SEPLOS_CELL_FIELDS":
+                analytics[name] = (field, 0)
+            else:
+                for cell in range(16):
+                    analytics[f"cell_{cell + 1}_{name}"] = (field, cell)
+    return analytics
+
+
+CELL_SENSORS = _load_cell_analytics()
+
+
+def field_keys_schema(fields):
+    return cv.Schema(
+        {
+            cv.Optional(CONF_BMS_INDEX): cv.int_range(min=0, max=MAX_BMS_COUNT - 1),
+            cv.Optional(CONF_FIELD): cv.one_of(*fields),
+        }
+    )
+
+
+def resolve_field_keys(fields):
+    # Ohne bms_index/field wird der Schlüssel einmalig beim Kompilieren aus "bms<N> <feld>" abgeleitet
+    def validator(config):
+        if CONF_BMS_INDEX in config and CONF_FIELD in config:
+            return config
+        if CONF_BMS_INDEX in config or CONF_FIELD in config:
+            raise cv.Invalid(f"'{CONF_BMS_INDEX}' und '{CONF_FIELD}' müssen zusammen angegeben werden")
+        name = config.get("name", "")
+        match = re.fullmatch(r"bms(\d+) (\w+)", name)
+        if match is None or match.group(2) not in fields:
+            raise cv.Invalid(
+                f"Kein '{CONF_BMS_INDEX}'/'{CONF_FIELD}' angegeben und Name '{name}' passt zu keinem Seplos-Feld "
+                f"(erwartet 'bms<N> <feld>' mit feld aus: {', '.join(fields)})"
+            )
+        if int(match.group(1)) >= MAX_BMS_COUNT:
+            raise cv.Invalid(f"BMS-Index in '{name}' muss kleiner als {MAX_BMS_COUNT} sein")
+        config = config.copy()
+        config[CONF_BMS_INDEX] = int(match.group(1))
+        config[CONF_FIELD] = match.group(2)
+        return config
+
+    return validator
+
+
 SeplosParser = seplos_parser_ns.class_("SeplosParser", cg.Component)
 
+FIELD_CLASSES = {
+    "voltage": seplos_parser_ns.CLASS_VOLTAGE,
+    "cell_voltage": seplos_parser_ns.CLASS_CELL_VOLTAGE,
+    "current": seplos_parser_ns.CLASS_CURRENT,
+    "temperature": seplos_parser_ns.CLASS_TEMPERATURE,
+    "capacity": seplos_parser_ns.CLASS_CAPACITY,
+    "percent": seplos_parser_ns.CLASS_PERCENT,
+    "counter": seplos_parser_ns.CLASS_COUNTER,
+    "power": seplos_parser_ns.CLASS_POWER,
+}
+
+PUBLISH_POLICY_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_MIN_INTERVAL): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_DEADBAND): cv.positive_float,
+        cv.Optional(CONF_RELATIVE_DEADBAND): cv.percentage,
+        cv.Optional(CONF_HEARTBEAT): cv.positive_time_period_milliseconds,
+    }
+)
+
+PUBLISH_POLICY_DEFAULTS = {
+    CONF_MIN_INTERVAL: cv.positive_time_period_milliseconds("0s"),
+    CONF_DEADBAND: 0.0,
+    CONF_RELATIVE_DEADBAND: 0.0,
+    CONF_HEARTBEAT: cv.positive_time_period_milliseconds("60s"),
+}
+
+# Binär-Upload der Rohregister, Format in seplos_uplink.h
+UPLINK_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_HTTP_REQUEST_ID): cv.use_id(http_request.HttpRequestComponent),
+        cv.Required(CONF_URL): cv.url,
+        cv.Optional(CONF_API_KEY, default=""): cv.string,
+        # Höchstens ein Eintrag je BMS und Block in diesem Abstand
+        cv.Optional(CONF_SAMPLE_INTERVAL, default="5s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_FLUSH_INTERVAL, default="300s"): cv.positive_time_period_milliseconds,
+        # Reicht der Puffer bis zum nächsten erfolgreichen Upload nicht, gehen die ältesten Einträge verloren
+        cv.Optional(CONF_BUFFER_SIZE, default=16384): cv.int_range(min=2048, max=262144),
+        # Ohne Verbindung wird der Puffer in diese Datenpartition geschrieben und später nachgesendet
+        cv.Optional(CONF_JOURNAL): cv.All(
+            cv.Schema({cv.Required(CONF_PARTITION): cv.string}),
+            cv.only_on_esp32,
+        ),
+    }
+)
+
+def _load_protection_alarms():
+    # Standardauslöser der Ereignisaufzeichnung: alle Schutzabschaltungen
+    header = (Path(__file__).parent / "seplos_registers.h").read_text()
+    body = header.split("#define SEPLOS_ALARM_BITS(F)", 1)[1].split("\n\n", 1)[0]
+    return re.findall(r"F\(\w+,\s*(\w+),\s*\d+,\s*0x[0-9A-Fa-f]+,\s*PROTECTION", body)
+
+
+PROTECTION_ALARMS = _load_protection_alarms()
+
+CAPTURE_SCHEMA = cv.Schema(
+    {
+        # Je Pack (pre_trigger + post_trigger) × 60 Byte RAM
+        cv.Optional(CONF_PRE_TRIGGER, default=50): cv.int_range(min=1, max=1000),
+        cv.Optional(CONF_POST_TRIGGER, default=25): cv.int_range(min=0, max=1000),
+        cv.Optional(CONF_TRIGGER, default=PROTECTION_ALARMS): cv.ensure_list(cv.one_of(*BINARY_SENSOR_FIELDS)),
+        # GET/POST /seplos/capture?bms=N über den vorhandenen web_server
+        cv.Optional(CONF_WEB_SERVER, default=False): cv.boolean,
+    }
+)
+
+HISTORY_DEFAULT_FIELDS = ["pack_voltage", "current", "soc", "max_cell_voltage", "min_cell_voltage", "max_cell_temp"]
+
+HISTORY_SCHEMA = cv.Schema(
+    {
+        # Je Pack und Minute 4 Byte + 6 Byte je Feld, im PSRAM, falls vorhanden
+        cv.Optional(CONF_RETENTION, default="6h"): cv.All(
+            cv.positive_time_period_minutes,
+            cv.Range(min=cv.TimePeriod(minutes=10), max=cv.TimePeriod(days=31)),
+        ),
+        cv.Optional(CONF_FIELDS, default=HISTORY_DEFAULT_FIELDS): cv.All(
+            cv.ensure_list(cv.one_of(*SENSOR_FIELDS)), cv.Length(min=1, max=64)
+        ),
+    }
+)
+
+MASTER_SCHEMA = cv.Schema(
+    {
+        # Takt je Block; fehlende Packs werden mit wachsendem Abstand (bis 60 s) weiter abgefragt
+        cv.Optional(CONF_PIA_INTERVAL, default="1s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_PIB_INTERVAL, default="5s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_PIC_INTERVAL, default="10s"): cv.positive_time_period_milliseconds,
+        # Alarmblock in diesem Takt, solange ein Alarm oder Schutz ansteht
+        cv.Optional(CONF_ALARM_INTERVAL, default="1s"): cv.positive_time_period_milliseconds,
+        # Höchstanteil der Buszeit für Anfragen und Antworten
+        cv.Optional(CONF_BUS_BUDGET, default="50%"): cv.All(cv.percentage, cv.Range(min=0.05)),
+        # Wartezeit auf den Antwortbeginn, zusätzlich zur Übertragungsdauer
+        cv.Optional(CONF_TIMEOUT, default="200ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_RETRIES, default=2): cv.int_range(min=0, max=5),
+        # DE/RE eines RS-485-Treibers ohne automatische Richtungsumschaltung
+        cv.Optional(CONF_FLOW_CONTROL_PIN): pins.gpio_output_pin_schema,
+    }
+)
+
+BUS_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_UART_ID): cv.use_id(uart.UARTComponent),
+        cv.Optional(CONF_BMS_COUNT, default=1): cv.int_range(min=1, max=MAX_BUS_ADDRESSES),
+    }
+)
+
+
+def total_bms_count(config):
+    return config[CONF_BMS_COUNT] + sum(bus[CONF_BMS_COUNT] for bus in config.get(CONF_BUSES, []))
+
+
+def validate_buses(config):
+    if total_bms_count(config) > MAX_BMS_COUNT:
+        raise cv.Invalid(f"Höchstens {MAX_BMS_COUNT} Packs über alle Busse")
+    return config
+
+
+def parent_config(config):
+    # Konfiguration des seplos_parser, auf den seplos_parser_id zeigt; nur in FINAL_VALIDATE_SCHEMA
+    full_config = fv.full_config.get()
+    return full_config.get_config_for_path(full_config.get_path_for_id(config[CONF_SEPLOS_PARSER_ID])[:-1])
+
+
+def final_validate_bms_index(config):
+    # Die Arrays je Pack sind nur bei mehr als 16 Packs über alle Busse größer als 16, siehe to_code()
+    if CONF_BMS_INDEX not in config:
+        return config
+    bms_count = total_bms_count(parent_config(config))
+    if config[CONF_BMS_INDEX] >= bms_count:
+        raise cv.Invalid(
+            f"'{CONF_BMS_INDEX}' {config[CONF_BMS_INDEX]} liegt außerhalb der {bms_count} konfigurierten Packs",
+            path=[CONF_BMS_INDEX],
+        )
+    return config
+
+
 HUB_CHILD_SCHEMA = cv.Schema(
     {
         cv.GenerateID(CONF_SEPLOS_PARSER_ID): cv.use_id(SeplosParser),
@@ -25,12 +342,59 @@ CONFIG_SCHEMA = (
     cv.Schema({
         cv.GenerateID(): cv.declare_id(SeplosParser),
         cv.Optional(CONF_UPDATE_INTERVAL, default=5): cv.int_,
-        cv.Optional(CONF_BMS_COUNT, default=1): cv.int_,
+        cv.Optional(CONF_BMS_COUNT, default=1): cv.int_range(min=1, max=MAX_BUS_ADDRESSES),
+        # "gap": Frames an Sendepausen (Modbus t3.5) trennen, Header-Suche nur als Rückfallebene
+        cv.Optional(CONF_FRAMING, default="header"): cv.one_of("header", "gap", lower=True),
+        # Ohne Angabe aus der Baudrate berechnet
+        cv.Optional(CONF_FRAME_GAP): cv.positive_time_period_microseconds,
+        # Höchstens so lange dekodiert eine loop() den aufgelaufenen Rückstand
+        cv.Optional(CONF_LOOP_BUDGET, default="4ms"): cv.positive_time_period_microseconds,
+        # Ohne gültige Antwort in dieser Zeit gilt ein Pack als offline
+        cv.Optional(CONF_STALE_TIMEOUT, default="60s"): cv.positive_time_period_milliseconds,
+        # Energiezähler über Neustarts hinweg aus dem Flash wiederherstellen
+        cv.Optional(CONF_RESTORE, default=True): cv.boolean,
+        # Tageszähler (*_today) um Mitternacht zurücksetzen; ohne time_id keine *_today-Sensoren
+        cv.Optional(CONF_TIME_ID): cv.use_id(time.RealTimeClock),
+        cv.Optional(CONF_UPLINK): UPLINK_SCHEMA,
+        cv.Optional(CONF_CAPTURE): CAPTURE_SCHEMA,
+        # GET /seplos/history über den vorhandenen web_server
+        cv.Optional(CONF_HISTORY): HISTORY_SCHEMA,
+        # Packs am eigenen UART selbst abfragen, nur ohne Seplos-Master auf diesem Bus; weitere Busse werden
+        # weiterhin mitgelesen
+        cv.Optional(CONF_MASTER): MASTER_SCHEMA,
+        # Weitere RS-485-Stränge mit eigenem UART; ihre Packs folgen im bms_index auf die des eigenen UART
+        cv.Optional(CONF_BUSES): cv.ensure_list(BUS_SCHEMA),
+        # Je Feldklasse; nicht aufgeführte Klassen übernehmen "default"
+        cv.Optional(CONF_PUBLISH_POLICY, default={}): cv.Schema(
+            {cv.Optional(name): PUBLISH_POLICY_SCHEMA for name in [CONF_DEFAULT, *FIELD_CLASSES]}
+        ),
     })
         .extend(cv.COMPONENT_SCHEMA)
         .extend(uart.UART_DEVICE_SCHEMA)
+        .add_extra(validate_buses)
 )
 
+
+def final_validate(config):
+    full_config = fv.full_config.get()
+    # Der Upload-Code bindet http_request ein; ohne die Komponente scheitert sonst erst das Linken
+    if CONF_UPLINK in config and "http_request" not in full_config:
+        raise cv.Invalid("'uplink' braucht eine 'http_request:'-Komponente in der Konfiguration", path=[CONF_UPLINK])
+    # Die Handler hängen sich an web_server_base, das web_server mitbringt
+    if config.get(CONF_CAPTURE, {}).get(CONF_WEB_SERVER) and "web_server_base" not in full_config:
+        raise cv.Invalid(
+            "'capture: web_server: true' braucht 'web_server:' in der Konfiguration",
+            path=[CONF_CAPTURE, CONF_WEB_SERVER],
+        )
+    # Der Verlauf ist nur über GET /seplos/history abrufbar
+    if CONF_HISTORY in config and "web_server_base" not in full_config:
+        raise cv.Invalid("'history' braucht 'web_server:' in der Konfiguration", path=[CONF_HISTORY])
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = final_validate
+
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
@@ -38,3 +402,64 @@ async def to_code(config):
 #    uart_device = await cg.get_variable(config[CONF_UART_ID])
     cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
     cg.add(var.set_bms_count(config[CONF_BMS_COUNT]))
+    for bus in config.get(CONF_BUSES, []):
+        cg.add(var.add_bus(await cg.get_variable(bus[CONF_UART_ID]), bus[CONF_BMS_COUNT]))
+    if total_bms_count(config) > 16:
+        cg.add_build_flag("-DSEPLOS_MAX_BMS_COUNT=48")
+    cg.add(var.set_gap_framing(config[CONF_FRAMING] == "gap"))
+    if CONF_FRAME_GAP in config:
+        cg.add(var.set_frame_gap(config[CONF_FRAME_GAP].total_microseconds))
+    cg.add(var.set_loop_budget(config[CONF_LOOP_BUDGET].total_microseconds))
+    cg.add(var.set_stale_timeout(config[CONF_STALE_TIMEOUT].total_milliseconds))
+    cg.add(var.set_restore_energy(config[CONF_RESTORE]))
+    # Eigener Schlüssel je Instanz, damit sich mehrere seplos_parser nicht gegenseitig überschreiben
+    cg.add(var.set_preference_key(str(config[CONF_ID])))
+    if CONF_TIME_ID in config:
+        cg.add(var.set_time(await cg.get_variable(config[CONF_TIME_ID])))
+    if CONF_UPLINK in config:
+        uplink = config[CONF_UPLINK]
+        cg.add_define("USE_SEPLOS_UPLINK")
+        http = await cg.get_variable(uplink[CONF_HTTP_REQUEST_ID])
+        cg.add(var.set_uplink(http, uplink[CONF_URL]))
+        cg.add(var.set_uplink_api_key(uplink[CONF_API_KEY]))
+        cg.add(var.set_uplink_sample_interval(uplink[CONF_SAMPLE_INTERVAL].total_milliseconds))
+        cg.add(var.set_uplink_flush_interval(uplink[CONF_FLUSH_INTERVAL].total_milliseconds))
+        cg.add(var.set_uplink_buffer_size(uplink[CONF_BUFFER_SIZE]))
+        if CONF_JOURNAL in uplink:
+            cg.add(var.set_journal_partition(uplink[CONF_JOURNAL][CONF_PARTITION]))
+    if CONF_CAPTURE in config:
+        capture = config[CONF_CAPTURE]
+        cg.add(var.set_capture(capture[CONF_PRE_TRIGGER], capture[CONF_POST_TRIGGER]))
+        for alarm in capture[CONF_TRIGGER]:
+            cg.add(var.add_capture_trigger(BINARY_SENSOR_FIELDS[alarm]))
+        if capture[CONF_WEB_SERVER]:
+            cg.add_define("USE_SEPLOS_CAPTURE_WEB")
+    if CONF_HISTORY in config:
+        history = config[CONF_HISTORY]
+        cg.add_define("USE_SEPLOS_HISTORY")
+        cg.add(var.set_history(history[CONF_RETENTION].total_minutes))
+        for field in history[CONF_FIELDS]:
+            cg.add(var.add_history_field(SENSOR_FIELDS[field]))
+    if CONF_MASTER in config:
+        master = config[CONF_MASTER]
+        cg.add(var.set_master(True))
+        for block, key in enumerate((CONF_PIA_INTERVAL, CONF_PIB_INTERVAL, CONF_PIC_INTERVAL)):
+            cg.add(var.set_master_interval(block, master[key].total_milliseconds))
+        cg.add(var.set_master_alarm_interval(master[CONF_ALARM_INTERVAL].total_milliseconds))
+        cg.add(var.set_master_bus_budget(master[CONF_BUS_BUDGET]))
+        cg.add(var.set_master_timeout(master[CONF_TIMEOUT].total_milliseconds))
+        cg.add(var.set_master_retries(master[CONF_RETRIES]))
+        if CONF_FLOW_CONTROL_PIN in master:
+            cg.add(var.set_flow_control_pin(await cg.gpio_pin_expression(master[CONF_FLOW_CONTROL_PIN])))
+    policies = config[CONF_PUBLISH_POLICY]
+    for name, field_class in FIELD_CLASSES.items():
+        policy = {**PUBLISH_POLICY_DEFAULTS, **policies.get(CONF_DEFAULT, {}), **policies.get(name, {})}
+        cg.add(
+            var.set_publish_policy(
+                field_class,
+                policy[CONF_MIN_INTERVAL].total_milliseconds,
+                policy[CONF_DEADBAND],
+                policy[CONF_RELATIVE_DEADBAND],
+                policy[CONF_HEARTBEAT].total_milliseconds,
+            )
+        )
@@ -1,19 +1,40 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import binary_sensor
-from . import HUB_CHILD_SCHEMA, CONF_EMPTY_SENSOR_HUB_ID
+from . import (
+    HUB_CHILD_SCHEMA,
+    CONF_SEPLOS_PARSER_ID,
+    CONF_BMS_INDEX,
+    CONF_FIELD,
+    BINARY_SENSOR_FIELDS,
+    field_keys_schema,
+    final_validate_bms_index,
+    resolve_field_keys,
+)
+
+DEPENDENCIES = ["seplos_parser"]
 
-DEPENDENCIES = ["empty_sensor_hub"]
+# Neben den Alarm-Bits: "online" folgt dem Empfang gültiger Antworten (stale_timeout)
+FIELD_ONLINE = "online"
+FIELDS = {**BINARY_SENSOR_FIELDS, FIELD_ONLINE: None}
 
 CONFIG_SCHEMA = (
     binary_sensor.binary_sensor_schema()
     .extend(HUB_CHILD_SCHEMA)
+    .extend(field_keys_schema(FIELDS))
     .extend(cv.COMPONENT_SCHEMA)
+    .add_extra(resolve_field_keys(FIELDS))
 )
 
 
+FINAL_VALIDATE_SCHEMA = final_validate_bms_index
+
+
 async def to_code(config):
-    paren = await cg.get_variable(config[CONF_EMPTY_SENSOR_HUB_ID])
+    paren = await cg.get_variable(config[CONF_SEPLOS_PARSER_ID])
     var = await binary_sensor.new_binary_sensor(config)
 
-    cg.add(paren.register_binary_sensor(var))
+    if config[CONF_FIELD] == FIELD_ONLINE:
+        cg.add(paren.register_online_sensor(config[CONF_BMS_INDEX], var))
+    else:
+        cg.add(paren.register_binary_sensor(config[CONF_BMS_INDEX], FIELDS[config[CONF_FIELD]], var))
@@ -1,22 +1,112 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import sensor
-from esphome.const import UNIT_EMPTY, ICON_EMPTY
-from . import HUB_CHILD_SCHEMA, CONF_SEPLOS_PARSER_ID
+from esphome.const import CONF_TIME_ID, UNIT_EMPTY, ICON_EMPTY
+from . import (
+    HUB_CHILD_SCHEMA,
+    CONF_SEPLOS_PARSER_ID,
+    CONF_BMS_INDEX,
+    CONF_FIELD,
+    CONF_DIAGNOSTIC,
+    CONF_BANK,
+    CONF_STATISTIC,
+    SENSOR_FIELDS,
+    DIAGNOSTIC_SENSORS,
+    PACK_DIAGNOSTIC_SENSORS,
+    BANK_SENSORS,
+    STATISTIC_SENSORS,
+    ENERGY_SENSORS,
+    CELL_SENSORS,
+    field_keys_schema,
+    final_validate_bms_index,
+    parent_config,
+    resolve_field_keys,
+)
 
 DEPENDENCIES = ["seplos_parser"]
 
+
+def resolve_sensor_keys(config):
+    # Bank-Sensoren fassen alle Packs zusammen
+    if CONF_BANK in config:
+        if any(key in config for key in (CONF_BMS_INDEX, CONF_FIELD, CONF_DIAGNOSTIC, CONF_STATISTIC)):
+            raise cv.Invalid(
+                f"'{CONF_BANK}' schließt '{CONF_BMS_INDEX}'/'{CONF_FIELD}'/'{CONF_DIAGNOSTIC}'/'{CONF_STATISTIC}' aus"
+            )
+        return config
+    if CONF_STATISTIC in config:
+        if CONF_FIELD in config or CONF_DIAGNOSTIC in config:
+            raise cv.Invalid(f"'{CONF_STATISTIC}' schließt '{CONF_FIELD}'/'{CONF_DIAGNOSTIC}' aus")
+        if CONF_BMS_INDEX not in config:
+            raise cv.Invalid(f"'{CONF_STATISTIC}' braucht '{CONF_BMS_INDEX}'")
+        return config
+    # Diagnosesensoren gehören zum Parser, mit bms_index zu einem Pack
+    if CONF_DIAGNOSTIC in config:
+        if CONF_FIELD in config:
+            raise cv.Invalid(f"'{CONF_DIAGNOSTIC}' schließt '{CONF_FIELD}' aus")
+        if CONF_BMS_INDEX in config and config[CONF_DIAGNOSTIC] not in PACK_DIAGNOSTIC_SENSORS:
+            raise cv.Invalid(
+                f"Mit '{CONF_BMS_INDEX}' sind nur diese Diagnosewerte möglich: {', '.join(PACK_DIAGNOSTIC_SENSORS)}"
+            )
+        if CONF_BMS_INDEX not in config and config[CONF_DIAGNOSTIC] not in DIAGNOSTIC_SENSORS:
+            raise cv.Invalid(f"'{config[CONF_DIAGNOSTIC]}' braucht '{CONF_BMS_INDEX}'")
+        return config
+    return resolve_field_keys(SENSOR_FIELDS)(config)
+
+
 CONFIG_SCHEMA = (
     sensor.sensor_schema(
       unit_of_measurement=UNIT_EMPTY, icon=ICON_EMPTY, accuracy_decimals=2
     )
     .extend(HUB_CHILD_SCHEMA)
+    .extend(field_keys_schema(SENSOR_FIELDS))
+    .extend(
+        {
+            cv.Optional(CONF_DIAGNOSTIC): cv.one_of(*DIAGNOSTIC_SENSORS, *PACK_DIAGNOSTIC_SENSORS),
+            cv.Optional(CONF_BANK): cv.one_of(*BANK_SENSORS),
+            # Je Pack, mit bms_index
+            cv.Optional(CONF_STATISTIC): cv.one_of(*STATISTIC_SENSORS, *ENERGY_SENSORS, *CELL_SENSORS),
+        }
+    )
     .extend(cv.COMPONENT_SCHEMA)
+    .add_extra(resolve_sensor_keys)
 )
 
 
+def final_validate(config):
+    config = final_validate_bms_index(config)
+    # Ohne Uhrzeit ist Mitternacht unbekannt, und nach einem Neustart zählt die Laufzeit wieder ab 0
+    if config.get(CONF_STATISTIC, "").endswith("_today") and CONF_TIME_ID not in parent_config(config):
+        raise cv.Invalid(
+            f"'{config[CONF_STATISTIC]}' braucht '{CONF_TIME_ID}' am seplos_parser", path=[CONF_STATISTIC]
+        )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = final_validate
+
+
 async def to_code(config):
     paren = await cg.get_variable(config[CONF_SEPLOS_PARSER_ID])
     var = await sensor.new_sensor(config)
 
-    cg.add(paren.register_sensor(var))
+    if CONF_BANK in config:
+        cg.add(paren.register_bank_sensor(BANK_SENSORS[config[CONF_BANK]], var))
+    elif CONF_STATISTIC in config and config[CONF_STATISTIC] in ENERGY_SENSORS:
+        cg.add(paren.register_energy_sensor(config[CONF_BMS_INDEX], ENERGY_SENSORS[config[CONF_STATISTIC]], var))
+    elif CONF_STATISTIC in config and config[CONF_STATISTIC] in CELL_SENSORS:
+        field, cell = CELL_SENSORS[config[CONF_STATISTIC]]
+        cg.add(paren.register_cell_sensor(config[CONF_BMS_INDEX], field, cell, var))
+    elif CONF_STATISTIC in config:
+        quantity, window, aggregation = STATISTIC_SENSORS[config[CONF_STATISTIC]]
+        cg.add(paren.register_statistic_sensor(config[CONF_BMS_INDEX], quantity, window, aggregation, var))
+    elif CONF_DIAGNOSTIC in config and CONF_BMS_INDEX in config:
+        cg.add(
+            paren.register_pack_diagnostic_sensor(
+                config[CONF_BMS_INDEX], PACK_DIAGNOSTIC_SENSORS[config[CONF_DIAGNOSTIC]], var
+            )
+        )
+    elif CONF_DIAGNOSTIC in config:
+        cg.add(paren.register_diagnostic_sensor(DIAGNOSTIC_SENSORS[config[CONF_DIAGNOSTIC]], var))
+    else:
+        cg.add(paren.register_sensor(config[CONF_BMS_INDEX], SENSOR_FIELDS[config[CONF_FIELD]], var))
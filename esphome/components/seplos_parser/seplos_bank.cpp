@@ -0,0 +1,150 @@
+#include "seplos_bank.h"
+#include <cmath>
+
+namespace esphome {
+namespace seplos_parser {
+
+static int32_t fixed(float value, float scale) { return int32_t(lroundf(value * scale)); }
+
+void BankAggregator::add_(const Pack &pack, int sign) {
+  if (pack.has_values) {
+    current_ += sign * pack.current;
+    remaining_ += sign * pack.remaining;
+    capacity_ += sign * pack.capacity;
+    soc_weighted_ += sign * pack.soc_weighted;
+    power_ += sign * pack.power;
+    active_with_values_ += sign;
+  }
+  if (pack.has_cells) {
+    active_with_cells_ += sign;
+  }
+  online_ += sign;
+}
+
+void BankAggregator::update_pack(int pack, float pack_voltage, float current, float remaining_capacity,
+                                 float total_capacity, float soc, float max_cell_voltage, float min_cell_voltage) {
+  Pack &p = packs_[pack];
+  if (p.active) {
+    add_(p, -1);
+  }
+  p.current = fixed(current, 100.0f);
+  p.remaining = fixed(remaining_capacity, 100.0f);
+  p.capacity = fixed(total_capacity, 100.0f);
+  p.soc_weighted = int64_t(fixed(soc, 10.0f)) * p.capacity;
+  p.power = int64_t(fixed(pack_voltage, 100.0f)) * p.current;
+  p.has_values = true;
+  if (p.active) {
+    add_(p, +1);
+  }
+  set_cells_(pack, fixed(max_cell_voltage, 1000.0f), fixed(min_cell_voltage, 1000.0f));
+}
+
+void BankAggregator::update_cells(int pack, const float *cells, int count) {
+  int32_t max_cell = INT32_MIN;
+  int32_t min_cell = INT32_MAX;
+  for (int i = 0; i < count; i++) {
+    if (std::isnan(cells[i])) {
+      continue;
+    }
+    int32_t cell = fixed(cells[i], 1000.0f);
+    max_cell = cell > max_cell ? cell : max_cell;
+    min_cell = cell < min_cell ? cell : min_cell;
+  }
+  if (max_cell >= min_cell) {
+    set_cells_(pack, max_cell, min_cell);
+  }
+}
+
+void BankAggregator::set_cells_(int pack, int32_t max_cell, int32_t min_cell) {
+  Pack &p = packs_[pack];
+  if (!p.has_cells && p.active) {
+    active_with_cells_++;
+  }
+  p.has_cells = true;
+  p.max_cell = max_cell;
+  p.min_cell = min_cell;
+  if (!p.active) {
+    return;
+  }
+  // Nur wenn das haltende Pack sich vom Extremwert wegbewegt, müssen alle Packs neu betrachtet werden
+  if ((pack == max_holder_ && max_cell < max_cell_) || (pack == min_holder_ && min_cell > min_cell_)) {
+    recompute_extrema_();
+    return;
+  }
+  if (max_holder_ < 0 || max_cell >= max_cell_) {
+    max_cell_ = max_cell;
+    max_holder_ = pack;
+  }
+  if (min_holder_ < 0 || min_cell <= min_cell_) {
+    min_cell_ = min_cell;
+    min_holder_ = pack;
+  }
+}
+
+void BankAggregator::recompute_extrema_() {
+  max_holder_ = -1;
+  min_holder_ = -1;
+  for (int i = 0; i < MAX_BMS_COUNT; i++) {
+    const Pack &p = packs_[i];
+    if (!p.active || !p.has_cells) {
+      continue;
+    }
+    if (max_holder_ < 0 || p.max_cell > max_cell_) {
+      max_cell_ = p.max_cell;
+      max_holder_ = i;
+    }
+    if (min_holder_ < 0 || p.min_cell < min_cell_) {
+      min_cell_ = p.min_cell;
+      min_holder_ = i;
+    }
+  }
+}
+
+void BankAggregator::set_active(int pack, bool active) {
+  Pack &p = packs_[pack];
+  if (p.active == active) {
+    return;
+  }
+  p.active = active;
+  add_(p, active ? +1 : -1);
+  if (!p.has_cells) {
+    return;
+  }
+  if (active) {
+    set_cells_(pack, p.max_cell, p.min_cell);
+  } else if (pack == max_holder_ || pack == min_holder_) {
+    recompute_extrema_();
+  }
+}
+
+float BankAggregator::get(BankField field) const {
+  if (field == BANK_ONLINE_PACKS) {
+    return online_;
+  }
+  bool cells = active_with_cells_ > 0 && max_holder_ >= 0;
+  if (field == BANK_MIN_CELL_VOLTAGE || field == BANK_MAX_CELL_VOLTAGE || field == BANK_MAX_CELL_DELTA) {
+    if (!cells) {
+      return NAN;
+    }
+    switch (field) {
+      case BANK_MIN_CELL_VOLTAGE: return min_cell_ / 1000.0f;
+      case BANK_MAX_CELL_VOLTAGE: return max_cell_ / 1000.0f;
+      default: return (max_cell_ - min_cell_) / 1000.0f;
+    }
+  }
+  if (active_with_values_ == 0) {
+    return NAN;
+  }
+  switch (field) {
+    case BANK_TOTAL_CURRENT: return current_ / 100.0f;
+    case BANK_TOTAL_REMAINING_CAPACITY: return remaining_ / 100.0f;
+    case BANK_TOTAL_CAPACITY: return capacity_ / 100.0f;
+    // Nach Kapazität gewichtet: ein kleines Pack verschiebt den Bank-SOC weniger
+    case BANK_SOC: return capacity_ > 0 ? soc_weighted_ / (capacity_ * 10.0f) : NAN;
+    case BANK_POWER: return power_ / 10000.0f;
+    default: return NAN;
+  }
+}
+
+}  // namespace seplos_parser
+}  // namespace esphome
@@ -0,0 +1,86 @@
+#pragma once
+
+// Kennzahlen der ganzen Batteriebank über alle Packs. Reines C++ wie seplos_frame.h.
+// Summen werden in Festkomma geführt und bei jedem Frame nur um die Änderung des einen Packs
+// korrigiert; so bleiben sie exakt, egal wie oft Packs dazukommen oder wegfallen.
+
+#include "seplos_registers.h"
+#include <cstdint>
+
+// Als Sensor mit `bank: <name>` abrufbar; __init__.py liest diese Liste ebenfalls ein.
+// F(ENUM, name, class)
+#define SEPLOS_BANK_FIELDS(F) \
+  F(TOTAL_CURRENT,            total_current,            CURRENT) \
+  F(TOTAL_REMAINING_CAPACITY, total_remaining_capacity, CAPACITY) \
+  F(TOTAL_CAPACITY,           total_capacity,           CAPACITY) \
+  F(SOC,                      soc,                      PERCENT) \
+  F(POWER,                    power,                    POWER) \
+  F(MIN_CELL_VOLTAGE,         min_cell_voltage,         CELL_VOLTAGE) \
+  F(MAX_CELL_VOLTAGE,         max_cell_voltage,         CELL_VOLTAGE) \
+  F(MAX_CELL_DELTA,           max_cell_delta,           CELL_VOLTAGE) \
+  F(ONLINE_PACKS,             online_packs,             COUNTER)
+
+namespace esphome {
+namespace seplos_parser {
+
+#define SEPLOS_BANK_ENUM(key, ...) BANK_##key,
+enum BankField : uint8_t {
+  SEPLOS_BANK_FIELDS(SEPLOS_BANK_ENUM)
+  BANK_FIELD_COUNT
+};
+#undef SEPLOS_BANK_ENUM
+
+#define SEPLOS_BANK_CLASS(key, name, field_class) CLASS_##field_class,
+static constexpr FieldClass BANK_FIELD_CLASSES[BANK_FIELD_COUNT] = {SEPLOS_BANK_FIELDS(SEPLOS_BANK_CLASS)};
+#undef SEPLOS_BANK_CLASS
+
+class BankAggregator {
+ public:
+  // Neue Werte aus einer 0x24-Antwort (Einheiten wie die Sensoren: V, A, Ah, %, V je Zelle)
+  void update_pack(int pack, float pack_voltage, float current, float remaining_capacity, float total_capacity,
+                   float soc, float max_cell_voltage, float min_cell_voltage);
+  // Neue Zellspannungen aus einer 0x34-Antwort; NaN-Einträge (nicht gelesen) werden übersprungen
+  void update_cells(int pack, const float *cells, int count);
+  // Veraltete Packs zählen nicht mit, bis wieder ein Frame von ihnen kommt
+  void set_active(int pack, bool active);
+
+  // NaN, solange kein aktives Pack die Größe liefert
+  float get(BankField field) const;
+
+ protected:
+  // Beitrag eines Packs in Festkomma: cA, cAh, 0,0001 W, mV
+  struct Pack {
+    bool active{false};
+    bool has_values{false};
+    bool has_cells{false};
+    int32_t current{0};
+    int32_t remaining{0};
+    int32_t capacity{0};
+    int64_t soc_weighted{0};  // SOC in 0,1 % × Kapazität in cAh
+    int64_t power{0};
+    int32_t max_cell{0};
+    int32_t min_cell{0};
+  };
+
+  void add_(const Pack &pack, int sign);
+  void set_cells_(int pack, int32_t max_cell, int32_t min_cell);
+  void recompute_extrema_();
+
+  Pack packs_[MAX_BMS_COUNT];
+  int active_with_values_{0};
+  int active_with_cells_{0};
+  int online_{0};
+  int64_t current_{0};
+  int64_t remaining_{0};
+  int64_t capacity_{0};
+  int64_t soc_weighted_{0};
+  int64_t power_{0};
+  // Extremwerte und das Pack, das sie hält; neu gesucht wird nur, wenn dieses Pack sich davon entfernt
+  int32_t max_cell_{0};
+  int32_t min_cell_{0};
+  int max_holder_{-1};
+  int min_holder_{-1};
+};
+
+}  // namespace seplos_parser
+}  // namespace esphome
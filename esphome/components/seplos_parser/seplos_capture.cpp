@@ -0,0 +1,52 @@
+#include "seplos_capture.h"
+#include <cstring>
+
+namespace esphome {
+namespace seplos_parser {
+
+void CaptureRing::configure(uint16_t pre_trigger, uint16_t post_trigger) {
+  entries_.assign(size_t(pre_trigger) + post_trigger, CaptureEntry{});
+  post_trigger_ = post_trigger;
+  rearm();
+}
+
+void CaptureRing::rearm() {
+  head_ = 0;
+  count_ = 0;
+  remaining_ = 0;
+  state_ = CAPTURE_ARMED;
+}
+
+void CaptureRing::add(uint32_t now, BlockId block, const uint8_t *payload, size_t length) {
+  if (state_ == CAPTURE_FROZEN || entries_.empty() || length > sizeof(CaptureEntry::data)) {
+    return;
+  }
+  CaptureEntry *entry;
+  if (count_ < entries_.size()) {
+    entry = &entries_[(head_ + count_) % entries_.size()];
+    count_++;
+  } else {
+    entry = &entries_[head_];  // ältesten überschreiben
+    head_ = (head_ + 1) % entries_.size();
+  }
+  entry->time = now;
+  entry->block = block;
+  entry->length = uint8_t(length);
+  memcpy(entry->data, payload, length);
+  if (state_ == CAPTURE_TRIGGERED && --remaining_ == 0) {
+    state_ = CAPTURE_FROZEN;
+  }
+}
+
+void CaptureRing::trigger(uint32_t now, const uint8_t *bits) {
+  if (state_ != CAPTURE_ARMED || entries_.empty()) {
+    return;
+  }
+  trigger_time_ = now;
+  memcpy(trigger_bits_, bits, ALARM_BYTES);
+  remaining_ = post_trigger_;
+  state_ = remaining_ == 0 ? CAPTURE_FROZEN : CAPTURE_TRIGGERED;
+}
+
+}  // namespace seplos_parser
+}  // namespace esphome
@@ -0,0 +1,61 @@
+#pragma once
+
+// Ereignisaufzeichnung je Pack wie bei einem Oszilloskop: jeder vollständige 0x24/0x34-Frame landet in einem
+// Ring fester Größe; eine neu gesetzte Alarm-/Schutzbit-Flanke löst aus, danach werden noch post_trigger
+// Frames aufgenommen und der Ring eingefroren, bis er abgeholt und neu scharfgeschaltet wird.
+// Reines C++ wie seplos_frame.h.
+
+#include "seplos_registers.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace seplos_parser {
+
+enum CaptureState : uint8_t { CAPTURE_ARMED, CAPTURE_TRIGGERED, CAPTURE_FROZEN };
+
+struct CaptureEntry {
+  uint32_t time;  // millis()
+  BlockId block;
+  uint8_t length;
+  uint8_t data[52];  // Datenbytes der Antwort, längster Block 0x34
+};
+
+// Zustand einer Aufzeichnung, zusammen mit ihren Frames unter einer Sperre gelesen
+struct CaptureInfo {
+  CaptureState state;
+  size_t frames;
+  uint32_t trigger_time;
+  uint8_t trigger_bits[ALARM_BYTES];
+};
+
+class CaptureRing {
+ public:
+  // Speicher für pre_trigger + post_trigger Frames wird hier einmalig belegt
+  void configure(uint16_t pre_trigger, uint16_t post_trigger);
+  void add(uint32_t now, BlockId block, const uint8_t *payload, size_t length);
+  // Nur im Zustand ARMED wirksam; bits = die 18 Alarm-Bytes der 0x12-Antwort
+  void trigger(uint32_t now, const uint8_t *bits);
+  void rearm();
+
+  CaptureState state() const { return state_; }
+  size_t size() const { return count_; }
+  // 0 = ältester Frame
+  const CaptureEntry &entry(size_t index) const { return entries_[(head_ + index) % entries_.size()]; }
+  uint32_t trigger_time() const { return trigger_time_; }
+  const uint8_t *trigger_bits() const { return trigger_bits_; }
+
+ protected:
+  std::vector<CaptureEntry> entries_;
+  size_t head_{0};
+  size_t count_{0};
+  uint16_t post_trigger_{0};
+  uint16_t remaining_{0};  // nach dem Auslösen noch aufzunehmende Frames
+  CaptureState state_{CAPTURE_ARMED};
+  uint32_t trigger_time_{0};
+  uint8_t trigger_bits_[ALARM_BYTES]{};
+};
+
+}  // namespace seplos_parser
+}  // namespace esphome
@@ -0,0 +1,180 @@
+#include "seplos_cells.h"
+#include <algorithm>
+
+namespace esphome {
+namespace seplos_parser {
+
+// Gewicht eines dt zurückliegenden Werts bei Zeitkonstante tau
+static float decay(uint32_t dt, uint32_t tau) { return expf(-float(dt) / float(tau)); }
+
+void CellAnalytics::TrendRegression::add(double dt_hours, double weight, double y) {
+  // Ursprung um dt_hours auf den neuen Punkt verschieben, dann altern lassen
+  stt = weight * (stt - 2.0 * dt_hours * st + dt_hours * dt_hours * s0);
+  st = weight * (st - dt_hours * s0);
+  sty = weight * (sty - dt_hours * sy);
+  s0 = weight * s0 + 1.0;
+  sy = weight * sy + y;
+}
+
+float CellAnalytics::TrendRegression::slope() const {
+  if (s0 < 2.0) {
+    return NAN;
+  }
+  double mean_t = st / s0;
+  double variance = stt / s0 - mean_t * mean_t;
+  if (variance < 0.25 * 0.25) {
+    return NAN;  // weniger als etwa eine Stunde Verlauf
+  }
+  return float((sty / s0 - mean_t * sy / s0) / variance);
+}
+
+void CellAnalytics::add_current(uint32_t now, float current) {
+  if (std::isnan(current)) {
+    return;
+  }
+  if (has_pending_) {
+    confirm_step_(current);
+  }
+  current_ = current;
+  current_time_ = now;
+  has_current_ = true;
+}
+
+void CellAnalytics::add_cells(uint32_t now, const float *cells, int count) {
+  count = std::min(count, MAX_CELLS);
+  float sum = 0.0f, min = 0.0f, max = 0.0f;
+  int present = 0, last = -1;
+  for (int i = 0; i < count; i++) {
+    float value = cells[i];
+    if (std::isnan(value) || value <= 0.0f) {
+      continue;
+    }
+    min = present == 0 ? value : std::min(min, value);
+    max = present == 0 ? value : std::max(max, value);
+    sum += value;
+    present++;
+    last = i;
+  }
+  if (present < 2) {
+    return;
+  }
+  count = last + 1;  // Packs mit weniger Zellen melden die übrigen als 0 V
+  float mean = sum / present;
+  uint32_t dt = has_cells_ ? now - cells_time_ : 0;
+  float dt_hours = dt / 3600000.0f;
+  bool first = !has_cells_ || count != cell_count_;
+
+  delta_ = max - min;
+  float alpha = first ? 1.0f : 1.0f - decay(dt, DEVIATION_TAU_MS);
+  delta_average_ = first ? delta_ : delta_average_ + alpha * (delta_ - delta_average_);
+  if (first) {
+    trend_ = TrendRegression{};
+  }
+  trend_.add(dt_hours, decay(dt, TREND_TAU_MS), delta_ * 1000.0f);
+
+  float previous[MAX_CELLS];
+  std::copy(deviation_, deviation_ + MAX_CELLS, previous);
+  for (int i = 0; i < count; i++) {
+    float value = cells[i];
+    if (std::isnan(value) || value <= 0.0f) {
+      continue;
+    }
+    float deviation = value - mean;
+    deviation_[i] += alpha * (deviation - deviation_[i]);
+  }
+  if (!first) {
+    update_balancing_(decay(dt, BALANCING_TAU_MS), dt_hours, previous);
+  }
+
+  // Zellframe für die Widerstandsschätzung vormerken; gilt erst, wenn der nächste Strom ihn bestätigt
+  has_pending_ = has_current_ && now - current_time_ <= MAX_CURRENT_AGE_MS;
+  if (has_pending_) {
+    pending_.time = now;
+    pending_.current = current_;
+    for (int i = 0; i < MAX_CELLS; i++) {
+      pending_.cells[i] = i < count && cells[i] > 0.0f ? cells[i] : NAN;
+    }
+  }
+
+  cells_time_ = now;
+  cell_count_ = count;
+  has_cells_ = true;
+}
+
+void CellAnalytics::update_balancing_(float weight, float dt_hours, const float *previous) {
+  converged_ *= weight;
+  moved_ *= weight;
+  balanced_hours_ *= weight;
+  for (int i = 0; i < cell_count_; i++) {
+    if (!(balancing_mask_ & (1u << i))) {
+      continue;
+    }
+    // Positiv, wenn die Zelle sich dem Packmittel nähert
+    float change = fabsf(previous[i]) - fabsf(deviation_[i]);
+    converged_ += change;
+    moved_ += fabsf(change);
+    balanced_hours_ += dt_hours;
+  }
+}
+
+void CellAnalytics::confirm_step_(float current) {
+  has_pending_ = false;
+  if (fabsf(current - pending_.current) > CONFIRM_TOLERANCE_A) {
+    // Strom hat sich um den Zellframe herum geändert, Zuordnung unsicher; der letzte bestätigte Frame vor dem
+    // Sprung bleibt Bezugspunkt
+    return;
+  }
+  float delta_current = pending_.current - confirmed_.current;
+  if (has_confirmed_ && pending_.time - confirmed_.time <= MAX_STEP_MS && fabsf(delta_current) >= MIN_STEP_A) {
+    // Gleiche ΔI für alle Zellen; fehlende Zellen tragen in diesem Schritt nichts bei
+    sxx_ = RESISTANCE_FORGETTING * sxx_ + delta_current * delta_current;
+    float sum = 0.0f;
+    for (int i = 0; i < MAX_CELLS; i++) {
+      float delta_voltage = pending_.cells[i] - confirmed_.cells[i];
+      sxy_[i] *= RESISTANCE_FORGETTING;
+      if (!std::isnan(delta_voltage)) {
+        sxy_[i] += delta_current * delta_voltage;
+        sum += delta_voltage;
+      }
+    }
+    sxy_[MAX_CELLS] = RESISTANCE_FORGETTING * sxy_[MAX_CELLS] + delta_current * sum;
+    steps_++;
+  }
+  confirmed_ = pending_;
+  has_confirmed_ = true;
+}
+
+float CellAnalytics::get(CellField field, int cell) const {
+  bool resistance_known = steps_ >= MIN_RESISTANCE_STEPS && sxx_ > 0.0f;
+  switch (field) {
+    case ANALYTICS_CELL_DELTA: return delta_;
+    case ANALYTICS_CELL_DELTA_AVERAGE: return delta_average_;
+    case ANALYTICS_CELL_DELTA_TREND: return has_cells_ ? trend_.slope() : NAN;
+    case ANALYTICS_BALANCING_EFFECTIVENESS:
+      return moved_ > 0.0001f ? 100.0f * converged_ / moved_ : NAN;  // erst ab 0,1 mV Bewegung
+    case ANALYTICS_BALANCING_RATE:
+      return balanced_hours_ > 0.01f ? 1000.0f * converged_ / balanced_hours_ : NAN;
+    case ANALYTICS_PACK_RESISTANCE: return resistance_known ? 1000.0f * sxy_[MAX_CELLS] / sxx_ : NAN;
+    case ANALYTICS_CELL_RESISTANCE_MAX:
+    case ANALYTICS_CELL_RESISTANCE_MEAN: {
+      if (!resistance_known || cell_count_ == 0) {
+        return NAN;
+      }
+      float max = sxy_[0], sum = 0.0f;
+      for (int i = 0; i < cell_count_; i++) {
+        max = std::max(max, sxy_[i]);
+        sum += sxy_[i];
+      }
+      return 1000.0f * (field == ANALYTICS_CELL_RESISTANCE_MAX ? max : sum / cell_count_) / sxx_;
+    }
+    case ANALYTICS_RESISTANCE_STEPS: return steps_;
+    case ANALYTICS_CELL_DEVIATION:
+      return has_cells_ && cell >= 0 && cell < cell_count_ ? 1000.0f * deviation_[cell] : NAN;
+    case ANALYTICS_CELL_RESISTANCE:
+      return resistance_known && cell >= 0 && cell < cell_count_ ? 1000.0f * sxy_[cell] / sxx_ : NAN;
+    default: return NAN;
+  }
+}
+
+}  // namespace seplos_parser
+}  // namespace esphome
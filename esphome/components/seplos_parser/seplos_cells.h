@@ -0,0 +1,116 @@
+#pragma once
+
+// Zellanalyse je Pack, mitlaufend mit jedem Frame und ohne gespeicherte Messreihen: Zelldrift, Wirkung des
+// Balancings und Innenwiderstand je Zelle aus Spannungs- und Stromsprüngen. Alle Schätzer sind exponentiell
+// gewichtete Summen fester Größe, der Aufwand je Frame ist O(Zellen). Reines C++ wie seplos_frame.h, damit
+// tools/seplos_cells_replay.cpp dieselbe Rechnung auf aufgezeichnete Frames anwenden kann.
+
+#include <cmath>
+#include <cstdint>
+
+// Werte je Pack, F(ENUM, name)
+#define SEPLOS_CELL_FIELDS(F) \
+  F(CELL_DELTA,              cell_delta) \
+  F(CELL_DELTA_AVERAGE,      cell_delta_average) \
+  F(CELL_DELTA_TREND,        cell_delta_trend) \
+  F(BALANCING_EFFECTIVENESS, balancing_effectiveness) \
+  F(BALANCING_RATE,          balancing_rate) \
+  F(PACK_RESISTANCE,         pack_resistance) \
+  F(CELL_RESISTANCE_MAX,     cell_resistance_max) \
+  F(CELL_RESISTANCE_MEAN,    cell_resistance_mean) \
+  F(RESISTANCE_STEPS,        resistance_steps)
+
+// Werte je Zelle, als "cell_<n>_<name>", F(ENUM, name)
+#define SEPLOS_PER_CELL_FIELDS(F) \
+  F(CELL_DEVIATION,  deviation) \
+  F(CELL_RESISTANCE, resistance)
+
+namespace esphome {
+namespace seplos_parser {
+
+#define SEPLOS_CELL_FIELD_ENUM(key, name) ANALYTICS_##key,
+enum CellField : uint8_t {
+  SEPLOS_CELL_FIELDS(SEPLOS_CELL_FIELD_ENUM)
+  SEPLOS_PER_CELL_FIELDS(SEPLOS_CELL_FIELD_ENUM)
+  CELL_FIELD_COUNT
+};
+#undef SEPLOS_CELL_FIELD_ENUM
+
+class CellAnalytics {
+ public:
+  static const int MAX_CELLS = 16;
+  // Zeitkonstanten der Mittelwerte
+  static const uint32_t DEVIATION_TAU_MS = 3600000;    // Zelldrift, mittleres Delta und Balancing
+  static const uint32_t TREND_TAU_MS = 6 * 3600000;    // Steigung des Deltas
+  static const uint32_t BALANCING_TAU_MS = 3600000;    // Bewertung des Balancings
+  // Ein Stromsprung zählt nur, wenn er groß genug ist, beide Zellframes kurz hintereinander liegen und der
+  // Strom jeweils vom nächsten 0x24-Frame bestätigt wird (sonst fiel der Sprung zwischen Strom- und Zellframe)
+  static constexpr float MIN_STEP_A = 3.0f;
+  static const uint32_t MAX_STEP_MS = 3000;
+  static const uint32_t MAX_CURRENT_AGE_MS = 1500;
+  static constexpr float CONFIRM_TOLERANCE_A = 0.5f;
+  static constexpr float RESISTANCE_FORGETTING = 0.98f;  // je Sprung, ~50 Sprünge Gedächtnis
+  static const uint32_t MIN_RESISTANCE_STEPS = 3;
+
+  // Strom aus dem 0x24-Frame, A (Laden positiv)
+  void add_current(uint32_t now, float current);
+  // Zellspannungen aus dem 0x34-Frame, V; NaN oder 0 = Zelle nicht vorhanden
+  void add_cells(uint32_t now, const float *cells, int count);
+  // Bit i = Zelle i+1 wird gerade ausgeglichen (Bytes 9/10 der 0x12-Antwort)
+  void set_balancing(uint16_t mask) { balancing_mask_ = mask; }
+
+  // cell (0-basiert) nur für die Werte je Zelle; NaN solange keine Schätzung vorliegt.
+  // Delta in V, Abweichung in mV, Trend und Rate in mV/h, Widerstände in mΩ, Wirksamkeit in % (-100…100)
+  float get(CellField field, int cell = 0) const;
+
+ protected:
+  // Exponentiell gewichtete lineare Regression y über t in Stunden; der Ursprung liegt immer beim letzten Punkt,
+  // damit die Summen klein bleiben. double, weil sich s0·stt und st² bei langen Zeitkonstanten kaum unterscheiden.
+  struct TrendRegression {
+    double s0{0}, st{0}, stt{0}, sy{0}, sty{0};
+    void add(double dt_hours, double weight, double y);
+    float slope() const;
+  };
+
+  // Zellframe mit dem zuletzt gemessenen Strom
+  struct StepSample {
+    uint32_t time;
+    float current;
+    float cells[MAX_CELLS];
+  };
+
+  void update_balancing_(float weight, float dt_hours, const float *previous);
+  void confirm_step_(float current);
+
+  float current_{0.0f};
+  uint32_t current_time_{0};
+  bool has_current_{false};
+
+  uint32_t cells_time_{0};
+  bool has_cells_{false};
+  int cell_count_{0};
+  float delta_{NAN};
+  float delta_average_{NAN};
+  // Abweichung vom Packmittel über DEVIATION_TAU_MS, V; kurzzeitige Sprünge durch unterschiedliche
+  // Innenwiderstände mitteln sich heraus, sodass auch das Balancing daran bewertet wird
+  float deviation_[MAX_CELLS]{};
+  TrendRegression trend_;
+
+  // Balancing: Summen mit Vergessen über BALANCING_TAU_MS
+  uint16_t balancing_mask_{0};
+  float converged_{0.0f};      // Annäherung der ausgeglichenen Zellen an das Packmittel, V
+  float moved_{0.0f};          // gesamte Bewegung dieser Zellen, V
+  float balanced_hours_{0.0f};  // Zellstunden mit aktivem Balancing
+
+  // Innenwiderstand: Regression ΔV = R·ΔI durch den Ursprung je Zelle, [MAX_CELLS] = Zellsumme
+  StepSample pending_{};  // wartet auf die Bestätigung durch den nächsten Strom
+  StepSample confirmed_{};
+  bool has_pending_{false};
+  bool has_confirmed_{false};
+  float sxx_{0.0f};
+  float sxy_[MAX_CELLS + 1]{};
+  uint32_t steps_{0};
+};
+
+}  // namespace seplos_parser
+}  // namespace esphome
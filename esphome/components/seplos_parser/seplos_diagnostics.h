@@ -0,0 +1,97 @@
+#pragma once
+
+// Diagnosewerte des Parsers selbst (nicht der Packs). Als Sensor mit `diagnostic: <name>` abrufbar;
+// __init__.py liest diese Listen ebenfalls ein.
+//
+// F(ENUM, name)
+
+#include <cstddef>
+#include <cstdint>
+
+#define SEPLOS_DIAGNOSTICS(F) \
+  F(UART_BACKLOG,        uart_backlog) \
+  F(UART_OVERRUNS,       uart_overruns) \
+  F(FRAMES_DEFERRED,     frames_deferred) \
+  F(BYTES_RECEIVED,      bytes_received) \
+  F(FRAMES,              frames) \
+  F(FRAMES_PIA,          frames_pia) \
+  F(FRAMES_PIB,          frames_pib) \
+  F(FRAMES_PIC,          frames_pic) \
+  F(CRC_ERRORS,          crc_errors) \
+  F(RESYNC_BYTES,        resync_bytes) \
+  F(EVICTED_BYTES,       evicted_bytes) \
+  F(INVALID_BMS_IDS,     invalid_bms_ids) \
+  F(LOOP_TIME_P50,       loop_time_p50) \
+  F(LOOP_TIME_P99,       loop_time_p99) \
+  F(LOOP_TIME_MAX,       loop_time_max) \
+  F(PUBLISH_LATENCY_P50, publish_latency_p50) \
+  F(PUBLISH_LATENCY_P99, publish_latency_p99) \
+  F(PUBLISH_LATENCY_MAX, publish_latency_max) \
+  F(FREE_HEAP,           free_heap) \
+  F(MIN_FREE_HEAP,       min_free_heap) \
+  F(UPLINK_BUFFERED,     uplink_buffered) \
+  F(UPLINK_DROPPED,      uplink_dropped) \
+  F(UPLINK_FAILURES,     uplink_failures) \
+  F(JOURNAL_PENDING,     journal_pending) \
+  F(JOURNAL_DROPPED,     journal_dropped) \
+  F(MASTER_REQUESTS,     master_requests) \
+  F(MASTER_TIMEOUTS,     master_timeouts) \
+  F(MASTER_FAILURES,     master_failures) \
+  F(BUS_UTILIZATION,     bus_utilization)
+
+// Je Pack, zusätzlich mit bms_index
+#define SEPLOS_PACK_DIAGNOSTICS(F) \
+  F(FRAMES,     frames) \
+  F(FRAME_RATE, frame_rate)
+
+namespace esphome {
+namespace seplos_parser {
+
+#define SEPLOS_DIAGNOSTIC_ENUM(key, name) DIAG_##key,
+enum DiagnosticField : uint8_t {
+  SEPLOS_DIAGNOSTICS(SEPLOS_DIAGNOSTIC_ENUM)
+  DIAGNOSTIC_COUNT
+};
+#undef SEPLOS_DIAGNOSTIC_ENUM
+
+#define SEPLOS_PACK_DIAGNOSTIC_ENUM(key, name) PACK_DIAG_##key,
+enum PackDiagnosticField : uint8_t {
+  SEPLOS_PACK_DIAGNOSTICS(SEPLOS_PACK_DIAGNOSTIC_ENUM)
+  PACK_DIAGNOSTIC_COUNT
+};
+#undef SEPLOS_PACK_DIAGNOSTIC_ENUM
+
+// Zeitverteilung in Zweierpotenz-Klassen: Klasse i zählt Werte < 2^i µs, die letzte alles darüber.
+// Feste Größe, add() in konstanter Zeit.
+struct TimeHistogram {
+  static const int BUCKETS = 18;  // bis 131 ms
+
+  uint32_t counts[BUCKETS]{};
+  uint32_t samples{0};
+  uint32_t max{0};
+
+  void add(uint32_t us) {
+    int bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+    counts[bucket < BUCKETS ? bucket : BUCKETS - 1]++;
+    samples++;
+    if (us > max) {
+      max = us;
+    }
+  }
+  // Obere Grenze der Klasse, in die das Quantil fällt (0 ohne Messwerte)
+  uint32_t quantile(float q) const {
+    uint32_t rank = uint32_t(q * samples);
+    uint32_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+      seen += counts[i];
+      if (seen > rank) {
+        return i == BUCKETS - 1 ? max : (1u << i);
+      }
+    }
+    return max;
+  }
+  void reset() { *this = TimeHistogram(); }
+};
+
+}  // namespace seplos_parser
+}  // namespace esphome
@@ -0,0 +1,382 @@
+#include "seplos_frame.h"
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace seplos_parser {
+
+bool is_valid_header(const uint8_t *data) {
+  uint8_t function = data[1] & 0x7F;
+  return data[0] >= 0x01 && data[0] <= 0x10 && function >= 0x01 && function <= 0x04;
+}
+uint8_t expected_byte_count(uint8_t function, uint16_t count) {
+  // 0x01/0x02 liefern Bits, 0x03/0x04 liefern 16-Bit-Register
+  return function <= 0x02 ? (count + 7) / 8 : count * 2;
+}
+bool validate_crc(const uint8_t *data, size_t length) {
+  uint16_t received_crc = (data[length - 1] << 8) | data[length - 2];
+  uint16_t calculated_crc = calculate_modbus_crc(data, length - 2);
+  return received_crc == calculated_crc;
+}
+
+uint8_t *FrameScanner::prepare_write(size_t *space) {
+  // Restdaten an den Pufferanfang schieben, damit jeder Frame zusammenhängend im Speicher liegt
+  if (head_ > 0) {
+    memmove(buffer_, buffer_ + head_, tail_ - head_);
+    tail_ -= head_;
+    scan_ -= head_;
+    for (size_t i = 0; i < candidate_count_; i++) {
+      candidates_[i].start -= head_;
+      candidates_[i].crc_pos -= head_;
+    }
+    segment_end_ -= std::min(segment_end_, head_);
+    head_ = 0;
+  }
+  if (tail_ == BUFFER_SIZE) {
+    // Nur möglich, wenn next_frame() zwischen zwei Lesevorgängen nicht aufgerufen wurde: die ältesten
+    // Bytes opfern, damit weiter gelesen werden kann; der letzte mögliche Frame bleibt erhalten
+    size_t evict = BUFFER_SIZE - MAX_FRAME_LENGTH;
+    memmove(buffer_, buffer_ + evict, MAX_FRAME_LENGTH);
+    tail_ = MAX_FRAME_LENGTH;
+    scan_ = 0;
+    candidate_count_ = 0;
+    segment_closed_ = false;
+    stats_.evicted_bytes += evict;
+  }
+  *space = BUFFER_SIZE - tail_;
+  return buffer_ + tail_;
+}
+
+void FrameScanner::commit_write(size_t length) {
+  tail_ += length;
+  stats_.bytes_received += length;
+}
+
+bool FrameScanner::expects_response_(const uint8_t *data) const {
+  return request_.active && request_.address == data[0] && request_.function == data[1] &&
+         expected_byte_count(request_.function, request_.count) == data[2];
+}
+
+void FrameScanner::open_candidate_(size_t start) {
+  const uint8_t *data = buffer_ + start;
+  Candidate &candidate = candidates_[candidate_count_++];
+  candidate.start = start;
+  candidate.response_length = (data[1] & 0x80) ? 5 : 5 + data[2];  // +3 Header, +2 CRC
+  // Anfragen (8 Byte) gibt es nur ohne Ausnahme-Bit
+  candidate.request_possible = !(data[1] & 0x80) && candidate.response_length != 8;
+  candidate.checked = 0;
+  candidate.crc_pos = start;
+  candidate.crc = 0xFFFF;
+}
+
+// Ein Kandidat, hinter dem nicht weitergesucht werden muss: erwartete Antwort auf die mitgelesene Anfrage (siehe
+// advance_candidate_()), Ausnahme-Antwort oder mögliche Anfrage, die nach 8 Byte entschieden ist. Ein ungepaarter Byte-Count dagegen
+// kann von einem Störheader stammen und den echten Frame dahinter bis zu 260 Byte lang aufhalten.
+bool FrameScanner::trusted_(const Candidate &candidate) const {
+  return !candidate.request_possible || candidate.checked < 8;
+}
+
+// CRC nur über die seit dem letzten Aufruf neu eingetroffenen Bytes fortschreiben und jede vollständig
+// vorliegende Länge einmal prüfen, die kürzere zuerst
+FrameScanner::CandidateResult FrameScanner::advance_candidate_(Candidate *candidate, size_t limit,
+                                                                size_t *frame_end) {
+  size_t lengths[2] = {candidate->response_length, candidate->response_length};
+  if (candidate->request_possible) {
+    lengths[0] = std::min<size_t>(8, candidate->response_length);
+    lengths[1] = std::max<size_t>(8, candidate->response_length);
+  }
+  for (size_t length : lengths) {
+    if (length <= candidate->checked) {
+      continue;
+    }
+    size_t end = candidate->start + length;
+    size_t crc_end = std::min(limit, end - 2);
+    if (candidate->crc_pos < crc_end) {
+      candidate->crc = update_modbus_crc(candidate->crc, buffer_ + candidate->crc_pos, crc_end - candidate->crc_pos);
+      candidate->crc_pos = crc_end;
+    }
+    if (limit < end) {
+      return CANDIDATE_PENDING;
+    }
+    candidate->checked = length;
+    // Wird von dieser Adresse gerade eine Antwort erwartet, zählt nur die Antwortlänge; sonst könnte
+    // eine zufällig passende CRC über die ersten 8 Byte die Antwort als Anfrage abschneiden
+    if (length != candidate->response_length && expects_response_(buffer_ + candidate->start)) {
+      candidate->request_possible = false;
+      continue;
+    }
+    uint16_t received_crc = (buffer_[end - 1] << 8) | buffer_[end - 2];
+    if (received_crc == candidate->crc) {
+      *frame_end = end;
+      return CANDIDATE_MATCHED;
+    }
+  }
+  return CANDIDATE_FAILED;
+}
+
+void FrameScanner::classify_(size_t start, size_t length, ModbusFrame *frame) {
+  const uint8_t *data = buffer_ + start;
+  frame->data = data;
+  frame->length = length;
+  frame->paired = false;
+  frame->start = 0;
+  frame->count = 0;
+
+  if (data[1] & 0x80) {
+    frame->kind = FRAME_EXCEPTION;
+    request_.active = false;
+    return;
+  }
+
+  bool response_matches = expects_response_(data);
+  // Bei Länge 8 sind Anfrage und Antwort mit 3 Datenbytes gleich lang, dann entscheidet die offene Anfrage
+  bool is_response = length != 8 || (5 + data[2] == 8 && response_matches);
+  if (!is_response) {
+    frame->kind = FRAME_REQUEST;
+    frame->paired = true;
+    frame->start = (data[2] << 8) | data[3];
+    frame->count = (data[4] << 8) | data[5];
+    request_.active = true;
+    request_.address = data[0];
+    request_.function = data[1];
+    request_.start = frame->start;
+    request_.count = frame->count;
+    stats_.requests++;
+    return;
+  }
+
+  frame->kind = FRAME_RESPONSE;
+  if (response_matches) {
+    frame->paired = true;
+    frame->start = request_.start;
+    frame->count = request_.count;
+  } else {
+    stats_.unpaired_responses++;
+  }
+  request_.active = false;
+}
+
+void FrameScanner::mark_gap() {
+  if (tail_ > head_) {
+    segment_closed_ = true;
+    segment_checked_ = false;
+    segment_end_ = tail_;
+  }
+}
+
+void FrameScanner::expect_response(uint8_t address, uint8_t function, uint16_t start, uint16_t count) {
+  request_.active = true;
+  request_.address = address;
+  request_.function = function;
+  request_.start = start;
+  request_.count = count;
+}
+
+bool FrameScanner::next_frame(ModbusFrame *frame) {
+  if (!gap_framing_) {
+    return scan_headers_(tail_, false, frame);
+  }
+  if (!segment_closed_) {
+    // Ohne Pause keine Frame-Grenze; erst wenn mehr als ein maximaler Frame ansteht, muss eine
+    // Pause übersehen worden sein und die Header-Suche übernimmt
+    return tail_ - head_ > MAX_FRAME_LENGTH && scan_headers_(tail_, false, frame);
+  }
+
+  if (!segment_checked_) {
+    // Im Normalfall ist der Abschnitt zwischen zwei Pausen genau ein Frame: eine CRC über alles
+    segment_checked_ = true;
+    candidate_count_ = 0;
+    const uint8_t *data = buffer_ + head_;
+    size_t length = segment_end_ - head_;
+    bool header = length >= 3 && is_valid_header(data);
+    size_t response_length = header ? ((data[1] & 0x80) ? 5 : 5 + size_t(data[2])) : 0;  // +3 Header, +2 CRC
+    if (header && length < response_length && !(length >= 8 && !(data[1] & 0x80) && validate_crc(data, 8))) {
+      // Der Header verlangt mehr Bytes, als vor der Pause kamen, und vorne steht auch keine Anfrage: keine echte
+      // Pause, weiter sammeln
+      segment_closed_ = false;
+      stats_.gap_splits++;
+      return false;
+    }
+    if (header && length >= 5) {
+      bool plausible = length == response_length || (length == 8 && !(data[1] & 0x80));
+      uint16_t received_crc = (data[length - 1] << 8) | data[length - 2];
+      if (plausible && update_modbus_crc(0xFFFF, data, length - 2) == received_crc) {
+        size_t start = head_;
+        head_ = scan_ = segment_end_;
+        segment_closed_ = false;
+        stats_.frames++;
+        stats_.gap_frames++;
+        classify_(start, length, frame);
+        return true;
+      }
+    }
+    // Mehrere Frames ohne erkannte Pause dazwischen (oder gestörter Frame): Header-Suche im Abschnitt
+    stats_.gap_fallbacks++;
+    scan_ = head_;
+  }
+
+  if (scan_headers_(segment_end_, true, frame)) {
+    return true;
+  }
+  if (!segment_closed_) {
+    return false;  // ein Kandidat reicht über die Pause hinaus, siehe scan_headers_()
+  }
+  // Kein Frame reicht über eine Pause hinweg, der Rest des Abschnitts ist verloren
+  stats_.resync_bytes += segment_end_ - head_;
+  head_ = scan_ = segment_end_;
+  candidate_count_ = 0;
+  segment_closed_ = false;
+  return false;
+}
+
+// limit: Ende der zu durchsuchenden Daten; bounded: hinter limit kommen keine Bytes dieses Frames mehr
+bool FrameScanner::scan_headers_(size_t limit, bool bounded, ModbusFrame *frame) {
+  bool progress = true;
+  while (progress) {
+    progress = false;
+    // Jede Startposition wird genau einmal auf einen Header geprüft. Hinter einem Kandidaten mit ungepaartem
+    // Byte-Count wird parallel weitergesucht, damit ein Störheader den echten Frame dahinter nicht aufhält; hinter
+    // einem vertrauenswürdigen liegen fast immer nur Nutzdaten, dort wird erst nach seiner Entscheidung weitergesucht.
+    if (candidate_count_ == 0 || !trusted_(candidates_[candidate_count_ - 1])) {
+      while (candidate_count_ < MAX_CANDIDATES && scan_ + 3 <= limit) {
+        if (!is_valid_header(buffer_ + scan_)) {
+          scan_++;
+          continue;
+        }
+        open_candidate_(scan_);
+        scan_++;
+        if (trusted_(candidates_[candidate_count_ - 1])) {
+          break;
+        }
+      }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < candidate_count_; i++) {
+      size_t frame_end;
+      CandidateResult result = advance_candidate_(&candidates_[i], limit, &frame_end);
+      if (result == CANDIDATE_PENDING) {
+        candidates_[kept++] = candidates_[i];
+        continue;
+      }
+      if (result == CANDIDATE_FAILED) {
+        stats_.crc_errors++;
+        progress = true;  // Platz für weitere Startpositionen
+        continue;
+      }
+      // Der früheste gültige Frame gewinnt. Noch offene Kandidaten davor waren Störungen, solche innerhalb des
+      // Frames Nutzdaten; übrig bleiben nur die dahinter, ihre CRC läuft weiter.
+      size_t start = candidates_[i].start;
+      size_t rest = 0;
+      for (size_t j = i + 1; j < candidate_count_; j++) {
+        if (candidates_[j].start >= frame_end) {
+          candidates_[rest++] = candidates_[j];
+        }
+      }
+      candidate_count_ = rest;
+      stats_.resync_bytes += start - head_;
+      head_ = frame_end;
+      scan_ = std::max(scan_, frame_end);
+      stats_.frames++;
+      classify_(start, frame_end - start, frame);
+      return true;
+    }
+    candidate_count_ = kept;
+    // Hat der letzte Kandidat seine Anfragelänge verworfen, darf hinter ihm weitergesucht werden
+    progress = progress || (scan_ + 3 <= limit && candidate_count_ < MAX_CANDIDATES &&
+                            (candidate_count_ == 0 || !trusted_(candidates_[candidate_count_ - 1])));
+  }
+
+  if (bounded && candidate_count_ > 0) {
+    // Laut Header reicht ein Frame über die gemeldete Pause hinaus. Meist war es keine: der UART-Treiber
+    // übergibt die Bytes schubweise, und zwischen zwei Schüben sah loop() länger als t3.5 nichts. Die
+    // Kandidaten behalten und den Abschnitt wieder öffnen, statt den Frame zu zerschneiden.
+    segment_closed_ = false;
+    stats_.gap_splits++;
+  }
+  // Bytes vor dem ältesten offenen Kandidaten (bzw. vor der nächsten ungeprüften Position) sind verloren
+  size_t keep = candidate_count_ > 0 ? candidates_[0].start : scan_;
+  stats_.resync_bytes += keep - head_;
+  head_ = keep;
+  return false;
+}
+
+static constexpr uint16_t crc_table[256] = {
+  0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+  0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+  0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+  0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+  0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+  0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+  0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+  0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+  0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+  0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+  0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+  0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+  0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+  0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+  0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+  0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+  0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+  0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+  0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+  0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+  0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+  0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+  0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+  0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+  0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+  0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+  0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+  0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+  0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+  0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+  0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+  0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+// Slice-by-8: Tabelle k liefert den Beitrag eines Bytes, auf das noch k weitere Bytes folgen.
+// Die Tabellen werden zur Übersetzungszeit aus crc_table erzeugt und liegen im Flash.
+struct CrcSliceTables {
+  uint16_t table[8][256];
+};
+
+static constexpr CrcSliceTables make_crc_slice_tables() {
+  CrcSliceTables tables{};
+  for (int i = 0; i < 256; i++) {
+    tables.table[0][i] = crc_table[i];
+  }
+  for (int k = 1; k < 8; k++) {
+    for (int i = 0; i < 256; i++) {
+      uint16_t prev = tables.table[k - 1][i];
+      tables.table[k][i] = (prev >> 8) ^ crc_table[prev & 0xFF];
+    }
+  }
+  return tables;
+}
+
+static constexpr CrcSliceTables crc_slices = make_crc_slice_tables();
+
+uint16_t update_modbus_crc(uint16_t crc, const uint8_t *data, size_t length) {
+  const uint16_t(*t)[256] = crc_slices.table;
+  while (length >= 8) {
+    uint8_t b0 = data[0] ^ (crc & 0xFF);
+    uint8_t b1 = data[1] ^ (crc >> 8);
+    crc = t[7][b0] ^ t[6][b1] ^ t[5][data[2]] ^ t[4][data[3]] ^
+          t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+    data += 8;
+    length -= 8;
+  }
+  while (length--) {
+    crc = (crc >> 8) ^ crc_table[(crc ^ *data++) & 0xFF];
+  }
+  return crc;
+}
+
+uint16_t calculate_modbus_crc(const uint8_t *data, size_t length) {
+  return update_modbus_crc(0xFFFF, data, length);
+}
+
+}  // namespace seplos_parser
+}  // namespace esphome
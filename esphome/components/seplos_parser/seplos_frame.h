@@ -0,0 +1,129 @@
+#pragma once
+
+// Framing-Kern des Seplos-Parsers: reines C++ ohne ESPHome-Abhängigkeiten,
+// damit er auch auf dem Host (Linux) übersetzt und mit Mitschnitten gefüttert werden kann.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace seplos_parser {
+
+uint16_t calculate_modbus_crc(const uint8_t *data, size_t length);
+// Schreibt einen laufenden CRC-Zustand (Startwert 0xFFFF) um weitere Bytes fort
+uint16_t update_modbus_crc(uint16_t crc, const uint8_t *data, size_t length);
+bool validate_crc(const uint8_t *data, size_t length);
+
+// Adresse 0x01-0x10 und Funktion 0x01-0x04 (oder deren Ausnahme-Antwort 0x81-0x84)
+bool is_valid_header(const uint8_t *data);
+// Bytes, die eine Antwort auf eine Leseanfrage mit count Registern/Bits enthält
+uint8_t expected_byte_count(uint8_t function, uint16_t count);
+
+// Adresse, Funktion, Byte-Count vor den Datenbytes einer Antwort
+static const size_t RESPONSE_HEADER_SIZE = 3;
+// Antwort mit 255 Datenbytes
+static const size_t MAX_FRAME_LENGTH = RESPONSE_HEADER_SIZE + 255 + 2;
+
+enum FrameKind : uint8_t { FRAME_REQUEST, FRAME_RESPONSE, FRAME_EXCEPTION };
+
+struct ModbusFrame {
+  const uint8_t *data;  // zeigt in den Puffer des Scanners, gültig bis zum nächsten prepare_write()
+  size_t length;
+  FrameKind kind;
+  // Für Anfragen immer, für Antworten nur wenn paired: Startadresse und Anzahl der Register/Bits
+  bool paired;
+  uint16_t start;
+  uint16_t count;
+};
+
+struct FrameScannerStats {
+  uint32_t bytes_received{0};
+  uint32_t frames{0};
+  uint32_t requests{0};
+  uint32_t unpaired_responses{0};  // Antworten ohne passende mitgelesene Anfrage
+  // Kandidaten mit gültigem Header, aber falscher CRC: fast immer eine Fehlsynchronisation
+  // auf Nutzdaten, die wie ein Header aussehen
+  uint32_t crc_errors{0};
+  uint32_t resync_bytes{0};   // beim Suchen eines Headers verworfene Bytes
+  uint32_t evicted_bytes{0};  // wegen vollem Puffer ungeprüft verworfene Bytes
+  uint32_t gap_frames{0};     // Pausen-Modus: Abschnitte, die mit einer einzigen CRC als Frame bestätigt wurden
+  uint32_t gap_fallbacks{0};  // Pausen-Modus: Abschnitte, die per Header-Suche zerlegt werden mussten
+  // Pausen-Modus: Frames, die laut Header über eine gemeldete Pause hinausreichten. Meist keine echte Pause, sondern
+  // ein UART-Treiber, der die Bytes schubweise übergibt.
+  uint32_t gap_splits{0};
+};
+
+// Liest passiv Modbus-RTU mit: Anfragen des Masters (8 Byte) und Antworten der Slaves
+// (Länge aus dem Byte-Count-Feld) werden als Ganzes erkannt, Antworten mit der
+// vorausgehenden Anfrage gepaart, sodass ihre Startadresse bekannt ist.
+class FrameScanner {
+ public:
+  // Reicht für die längste Modbus-Antwort (255 Byte) plus einen vollen UART-Lesevorgang
+  static const size_t BUFFER_SIZE = 512;
+
+  // Schiebt Restdaten an den Pufferanfang und liefert den freien Bereich für read_array()
+  uint8_t *prepare_write(size_t *space);
+  void commit_write(size_t length);
+  size_t pending() const { return tail_ - head_; }
+
+  // Liefert true und füllt frame, sobald ein vollständiger Frame mit gültiger CRC vorliegt
+  bool next_frame(ModbusFrame *frame);
+
+  // Pausen-Modus (Modbus t3.5): Frames werden nur an gemeldeten Sendepausen getrennt,
+  // die Header-Suche dient nur noch als Rückfallebene innerhalb eines Abschnitts
+  void set_gap_framing(bool gap_framing) { gap_framing_ = gap_framing; }
+  // Meldet, dass nach den bisher geschriebenen Bytes mindestens t3.5 Ruhe auf dem Bus war
+  void mark_gap();
+  // Master-Betrieb: eigene Anfrage vormerken, damit die Antwort gepaart wird, auch ohne Echo auf dem Bus
+  void expect_response(uint8_t address, uint8_t function, uint16_t start, uint16_t count);
+
+  const FrameScannerStats &get_stats() const { return stats_; }
+
+ protected:
+  // Offene Frame-Kandidaten, einer je Header-Position; jeder führt seine eigene CRC, sodass kein Byte nach einem
+  // Fehlschlag erneut eingerechnet wird. Ein Header kann eine Anfrage
+  // oder eine Antwort einleiten, beide möglichen Längen werden der Reihe nach geprüft.
+  static const size_t MAX_CANDIDATES = 8;
+  struct Candidate {
+    uint16_t start;
+    uint16_t response_length;
+    bool request_possible;  // auch 8 Byte (Anfrage) prüfen; false, sobald es die erwartete Antwort ist
+    uint16_t checked;       // längste bereits geprüfte Länge
+    uint16_t crc_pos;       // erstes noch nicht eingerechnetes Byte
+    uint16_t crc;
+  };
+  enum CandidateResult : uint8_t { CANDIDATE_PENDING, CANDIDATE_MATCHED, CANDIDATE_FAILED };
+
+  // Zuletzt gesehene, noch unbeantwortete Anfrage des Masters
+  struct PendingRequest {
+    bool active{false};
+    uint8_t address;
+    uint8_t function;
+    uint16_t start;
+    uint16_t count;
+  };
+
+  bool expects_response_(const uint8_t *data) const;
+  void open_candidate_(size_t start);
+  bool trusted_(const Candidate &candidate) const;
+  CandidateResult advance_candidate_(Candidate *candidate, size_t limit, size_t *frame_end);
+  bool scan_headers_(size_t limit, bool bounded, ModbusFrame *frame);
+  void classify_(size_t start, size_t length, ModbusFrame *frame);
+
+  uint8_t buffer_[BUFFER_SIZE];
+  size_t head_{0};  // gültige Daten liegen in [head_, tail_)
+  size_t tail_{0};
+  size_t scan_{0};  // nächste auf einen Header zu prüfende Startposition
+  Candidate candidates_[MAX_CANDIDATES];  // nach Startposition sortiert
+  size_t candidate_count_{0};
+  PendingRequest request_;
+  FrameScannerStats stats_;
+
+  bool gap_framing_{false};
+  bool segment_closed_{false};   // [head_, segment_end_) ist durch eine Pause abgeschlossen
+  bool segment_checked_{false};  // Ganz-Abschnitt-CRC bereits versucht
+  size_t segment_end_{0};
+};
+
+}  // namespace seplos_parser
+}  // namespace esphome
@@ -0,0 +1,226 @@
+#include "seplos_history.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace esphome {
+namespace seplos_parser {
+
+static const char *const AGGREGATION_NAMES[STAT_AGGREGATION_COUNT] = {"min", "max", "mean"};
+
+static const FieldDescriptor *find_descriptor(SensorField field, BlockId *block) {
+  for (const BlockDescriptor &candidate : BLOCKS) {
+    for (uint8_t i = 0; i < candidate.field_count; i++) {
+      if (candidate.fields[i].field == field) {
+        *block = candidate.id;
+        return &candidate.fields[i];
+      }
+    }
+  }
+  return nullptr;
+}
+
+// Zurück auf die Registerauflösung, damit jede Spalte mit 16 Bit auskommt
+static uint16_t encode_value(const FieldDescriptor &desc, float value) {
+  long raw = lroundf((value - desc.add) * desc.divisor);
+  if (desc.is_signed) {
+    raw = std::max(-32767L, std::min(32767L, raw));  // -32768 ist NO_VALUE
+  } else {
+    raw = std::max(0L, std::min(65535L, raw));
+    if (raw == 0x8000) {
+      raw = 0x8001;
+    }
+  }
+  return uint16_t(raw);
+}
+
+void HistoryRing::configure(const std::vector<SensorField> *fields, size_t slots, uint8_t *storage) {
+  fields_ = fields;
+  slots_ = slots;
+  times_ = reinterpret_cast<uint32_t *>(storage);
+  columns_ = reinterpret_cast<uint16_t *>(storage + slots * sizeof(uint32_t));
+  descriptors_.clear();
+  blocks_.clear();
+  for (SensorField field : *fields) {
+    BlockId block = BLOCK_PIA;
+    descriptors_.push_back(find_descriptor(field, &block));
+    blocks_.push_back(block);
+  }
+  accumulators_.assign(fields->size(), Accumulator{});
+  head_ = 0;
+  count_ = 0;
+  has_epoch_ = false;
+}
+
+void HistoryRing::add(uint32_t now, BlockId block, const float *values) {
+  if (slots_ == 0) {
+    return;
+  }
+  tick(now);
+  if (!has_epoch_) {
+    epoch_ = now / SLOT_MS;
+    has_epoch_ = true;
+    accumulators_.assign(accumulators_.size(), Accumulator{});
+  }
+  for (size_t i = 0; i < accumulators_.size(); i++) {
+    float value = values[(*fields_)[i]];
+    if (blocks_[i] != block || std::isnan(value)) {
+      continue;
+    }
+    Accumulator &acc = accumulators_[i];
+    if (acc.count == 0) {
+      acc.min = acc.max = value;
+      acc.sum = 0.0f;
+    } else {
+      acc.min = std::min(acc.min, value);
+      acc.max = std::max(acc.max, value);
+    }
+    acc.sum += value;
+    acc.count++;
+  }
+}
+
+void HistoryRing::tick(uint32_t now) {
+  if (has_epoch_ && now / SLOT_MS != epoch_) {
+    commit_();
+    has_epoch_ = false;
+  }
+}
+
+void HistoryRing::commit_() {
+  size_t index;
+  if (count_ < slots_) {
+    index = (head_ + count_) % slots_;
+    count_++;
+  } else {
+    index = head_;  // älteste Minute überschreiben
+    head_ = (head_ + 1) % slots_;
+  }
+  times_[index] = epoch_ * SLOT_MS;
+  for (size_t i = 0; i < accumulators_.size(); i++) {
+    const Accumulator &acc = accumulators_[i];
+    const FieldDescriptor *desc = descriptors_[i];
+    bool valid = acc.count > 0 && desc != nullptr;
+    column_(i, AGG_MIN)[index] = valid ? encode_value(*desc, acc.min) : NO_VALUE;
+    column_(i, AGG_MAX)[index] = valid ? encode_value(*desc, acc.max) : NO_VALUE;
+    column_(i, AGG_MEAN)[index] = valid ? encode_value(*desc, acc.sum / acc.count) : NO_VALUE;
+  }
+  sequence_++;
+}
+
+float HistoryRing::value(uint32_t sequence, size_t field_index, StatAggregation aggregation) const {
+  uint16_t raw = column_(field_index, aggregation)[index_(sequence)];
+  if (raw == NO_VALUE) {
+    return NAN;
+  }
+  const FieldDescriptor &desc = *descriptors_[field_index];
+  float decoded = desc.is_signed ? float(int16_t(raw)) : float(raw);
+  return decoded / desc.divisor + desc.add;
+}
+
+HistoryCursor::HistoryCursor(const HistoryRing *ring, int bms_index, std::vector<uint8_t> field_indices, uint32_t now,
+                             uint32_t unix_time, uint32_t from, uint32_t to)
+    : ring_(ring),
+      bms_index_(bms_index),
+      field_indices_(std::move(field_indices)),
+      now_(now),
+      unix_time_(unix_time),
+      from_(from),
+      to_(to) {
+  sequence_ = ring->first_sequence();
+}
+
+uint32_t HistoryCursor::row_time_(uint32_t sequence) const {
+  uint32_t slot_time = ring_->slot_time(sequence);
+  if (unix_time_ == 0) {
+    return slot_time / 1000;
+  }
+  return unix_time_ - (now_ - slot_time) / 1000;  // Abstand modulo 2^32 wie beim Upload
+}
+
+// Nachkommastellen der Registerauflösung, in der auch Mittelwerte gespeichert sind
+static int field_decimals(const FieldDescriptor &desc) {
+  return desc.divisor >= 1000.0f ? 3 : desc.divisor >= 100.0f ? 2 : desc.divisor >= 10.0f ? 1 : 0;
+}
+
+bool HistoryCursor::next_piece_() {
+  char number[24];
+  piece_.clear();
+  piece_position_ = 0;
+  if (phase_ == PHASE_HEADER) {
+    snprintf(number, sizeof(number), "%d", bms_index_);
+    piece_ = "{\"bms\":";
+    piece_ += number;
+    snprintf(number, sizeof(number), "%u", unsigned(HistoryRing::SLOT_MS / 1000));
+    piece_ += ",\"interval\":";
+    piece_ += number;
+    piece_ += unix_time_ != 0 ? ",\"clock\":\"unix\"" : ",\"clock\":\"uptime\"";
+    piece_ += ",\"columns\":[\"t\"";
+    for (uint8_t index : field_indices_) {
+      for (const char *aggregation : AGGREGATION_NAMES) {
+        piece_ += ",\"";
+        piece_ += SENSOR_FIELD_NAMES[ring_->fields()[index]];
+        piece_ += '_';
+        piece_ += aggregation;
+        piece_ += '"';
+      }
+    }
+    piece_ += "],\"rows\":[";
+    phase_ = PHASE_ROWS;
+    return true;
+  }
+  if (phase_ == PHASE_ROWS) {
+    // Während der Ausgabe überschriebene Minuten überspringen
+    sequence_ = std::max(sequence_, ring_->first_sequence());
+    while (sequence_ != ring_->end_sequence()) {
+      uint32_t sequence = sequence_++;
+      uint32_t time = row_time_(sequence);
+      if (time < from_) {
+        continue;
+      }
+      if (time > to_) {
+        break;
+      }
+      snprintf(number, sizeof(number), "%u", unsigned(time));
+      piece_ = first_row_ ? "[" : ",[";
+      piece_ += number;
+      for (uint8_t index : field_indices_) {
+        int decimals = field_decimals(*ring_->descriptor(index));
+        for (int aggregation = 0; aggregation < STAT_AGGREGATION_COUNT; aggregation++) {
+          float value = ring_->value(sequence, index, static_cast<StatAggregation>(aggregation));
+          if (std::isnan(value)) {
+            piece_ += ",null";
+            continue;
+          }
+          snprintf(number, sizeof(number), ",%.*f", decimals, value);
+          piece_ += number;
+        }
+      }
+      piece_ += ']';
+      first_row_ = false;
+      return true;
+    }
+    piece_ = "]}";
+    phase_ = PHASE_DONE;
+    return true;
+  }
+  return false;
+}
+
+size_t HistoryCursor::read(char *buffer, size_t max_length) {
+  size_t written = 0;
+  while (written < max_length) {
+    if (piece_position_ == piece_.size() && !next_piece_()) {
+      break;
+    }
+    size_t n = std::min(max_length - written, piece_.size() - piece_position_);
+    memcpy(buffer + written, piece_.data() + piece_position_, n);
+    piece_position_ += n;
+    written += n;
+  }
+  return written;
+}
+
+}  // namespace seplos_parser
+}  // namespace esphome
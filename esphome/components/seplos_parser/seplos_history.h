@@ -0,0 +1,106 @@
+#pragma once
+
+// Minutenverlauf je Pack für Diagramme direkt vom Gerät: Min/Max/Mittelwert ausgewählter Felder je Minute,
+// spaltenweise in einem Ring fester Größe. Den Speicher stellt der Aufrufer (PSRAM, falls vorhanden), die
+// Abfrage liefert HistoryCursor stückweise als JSON, ohne die Antwort vorher ganz aufzubauen.
+// Reines C++ wie seplos_frame.h.
+
+#include "seplos_registers.h"
+#include "seplos_stats.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace seplos_parser {
+
+class HistoryRing {
+ public:
+  static const uint32_t SLOT_MS = 60000;
+
+  // Bytes je Pack: Zeitspalte (4 Byte) und je Feld Min/Max/Mittelwert als Rohwert (je 2 Byte)
+  static size_t storage_size(size_t field_count, size_t slots) { return slots * (4 + field_count * 6); }
+
+  // fields gehört dem Aufrufer und gilt für alle Packs; storage hat storage_size() Bytes
+  void configure(const std::vector<SensorField> *fields, size_t slots, uint8_t *storage);
+  // Werte der Felder, die in block liegen; values ist nach SensorField indiziert, NaN = fehlt
+  void add(uint32_t now, BlockId block, const float *values);
+  // Abgelaufene Minute auch ohne neuen Frame abschließen
+  void tick(uint32_t now);
+
+  const std::vector<SensorField> &fields() const { return *fields_; }
+  const FieldDescriptor *descriptor(size_t field_index) const { return descriptors_[field_index]; }
+  // Fortlaufende Nummern der gespeicherten Minuten: [first_sequence, end_sequence)
+  uint32_t first_sequence() const { return sequence_ - count_; }
+  uint32_t end_sequence() const { return sequence_; }
+  // millis() zu Beginn der Minute
+  uint32_t slot_time(uint32_t sequence) const { return times_[index_(sequence)]; }
+  // NaN, wenn das Feld in dieser Minute nicht empfangen wurde
+  float value(uint32_t sequence, size_t field_index, StatAggregation aggregation) const;
+
+ protected:
+  static const uint16_t NO_VALUE = 0x8000;
+
+  struct Accumulator {
+    float min;
+    float max;
+    float sum;
+    uint32_t count;
+  };
+
+  size_t index_(uint32_t sequence) const { return (head_ + (sequence - first_sequence())) % slots_; }
+  uint16_t *column_(size_t field_index, StatAggregation aggregation) const {
+    return columns_ + (field_index * STAT_AGGREGATION_COUNT + aggregation) * slots_;
+  }
+  void commit_();
+
+  const std::vector<SensorField> *fields_{nullptr};
+  std::vector<const FieldDescriptor *> descriptors_;
+  std::vector<BlockId> blocks_;
+  size_t slots_{0};
+  uint32_t *times_{nullptr};
+  uint16_t *columns_{nullptr};
+  size_t head_{0};
+  size_t count_{0};
+  uint32_t sequence_{0};  // Anzahl bisher abgeschlossener Minuten
+
+  std::vector<Accumulator> accumulators_;
+  uint32_t epoch_{0};  // now / SLOT_MS der laufenden Minute
+  bool has_epoch_{false};
+};
+
+// Antwort von GET /seplos/history als JSON:
+//   {"bms":0,"interval":60,"clock":"unix","columns":["t","current_min",...],"rows":[[t,min,max,mean,...],...]}
+// t ist der Beginn der Minute in Unix-Sekunden, ohne gültige Uhrzeit ("clock":"uptime") in Sekunden seit dem
+// Start. read() darf zwischen zwei Aufrufen beliebig lange warten; inzwischen überschriebene Minuten fehlen.
+class HistoryCursor {
+ public:
+  // now/unix_time: derselbe Zeitpunkt (unix_time 0 = unbekannt); from/to in der Einheit von t, einschließlich
+  HistoryCursor(const HistoryRing *ring, int bms_index, std::vector<uint8_t> field_indices, uint32_t now,
+                uint32_t unix_time, uint32_t from, uint32_t to);
+  // Nächste höchstens max_length Bytes der Antwort; 0 = fertig
+  size_t read(char *buffer, size_t max_length);
+
+ protected:
+  enum Phase : uint8_t { PHASE_HEADER, PHASE_ROWS, PHASE_DONE };
+
+  bool next_piece_();
+  uint32_t row_time_(uint32_t sequence) const;
+
+  const HistoryRing *ring_;
+  int bms_index_;
+  std::vector<uint8_t> field_indices_;
+  uint32_t now_;
+  uint32_t unix_time_;
+  uint32_t from_;
+  uint32_t to_;
+  Phase phase_{PHASE_HEADER};
+  uint32_t sequence_{0};
+  bool first_row_{true};
+  std::string piece_;  // aktuell ausgegebenes Stück (Kopf, eine Zeile oder Abschluss)
+  size_t piece_position_{0};
+};
+
+}  // namespace seplos_parser
+}  // namespace esphome
@@ -0,0 +1,286 @@
+#include "seplos_journal.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace esphome {
+namespace seplos_parser {
+
+static const uint32_t SECTOR_MAGIC = 0x314A5053;  // "SPJ1"
+static const uint16_t RECORD_MAGIC = 0x5352;
+
+#ifdef USE_ESP32
+bool PartitionJournalStorage::open(const char *label) {
+  partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  return partition_ != nullptr;
+}
+
+size_t PartitionJournalStorage::size() const { return partition_->size; }
+
+bool PartitionJournalStorage::read(size_t offset, void *data, size_t length) {
+  return esp_partition_read(partition_, offset, data, length) == ESP_OK;
+}
+
+bool PartitionJournalStorage::write(size_t offset, const void *data, size_t length) {
+  return esp_partition_write(partition_, offset, data, length) == ESP_OK;
+}
+
+bool PartitionJournalStorage::erase_sector(size_t offset) {
+  return esp_partition_erase_range(partition_, offset, SECTOR_SIZE) == ESP_OK;
+}
+#endif
+
+// CRC-16/CCITT, bitweise: läuft nur beim Schreiben und einmal je Start über den letzten Sektor
+static uint16_t crc16(uint16_t crc, const uint8_t *data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    crc ^= uint16_t(data[i]) << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+size_t Journal::max_record_size() const {
+  return JournalStorage::SECTOR_SIZE - sizeof(SectorHeader) - sizeof(RecordHeader);
+}
+
+bool Journal::read_record_(size_t sector, size_t offset, RecordHeader *header) {
+  if (offset + sizeof(RecordHeader) > JournalStorage::SECTOR_SIZE ||
+      !storage_->read(sector_offset_(sector) + offset, header, sizeof(RecordHeader))) {
+    return false;
+  }
+  return header->magic == RECORD_MAGIC && offset + sizeof(RecordHeader) + header->length <= JournalStorage::SECTOR_SIZE;
+}
+
+bool Journal::record_valid_(size_t sector, size_t offset, const RecordHeader &header) {
+  uint16_t crc = crc16(0xFFFF, reinterpret_cast<const uint8_t *>(&header.anchor), sizeof(header.anchor));
+  uint8_t buffer[64];
+  size_t position = sector_offset_(sector) + offset + sizeof(RecordHeader);
+  for (size_t done = 0; done < header.length;) {
+    size_t n = std::min(sizeof(buffer), size_t(header.length - done));
+    if (!storage_->read(position + done, buffer, n)) {
+      return false;
+    }
+    crc = crc16(crc, buffer, n);
+    done += n;
+  }
+  return crc == header.crc;
+}
+
+bool Journal::next_record_(size_t *sector, size_t *offset, RecordHeader *header) {
+  while (!(*sector == head_sector_ && *offset >= head_offset_)) {
+    if (read_record_(*sector, *offset, header)) {
+      return true;
+    }
+    if (*sector == head_sector_) {
+      return false;  // Rest des Schreibsektors ist leer oder beschädigt
+    }
+    // Rest des Sektors ungenutzt
+    *sector = (*sector + 1) % sectors_;
+    *offset = sizeof(SectorHeader);
+  }
+  return false;
+}
+
+bool Journal::begin(JournalStorage *storage) {
+  storage_ = storage;
+  sectors_ = storage->size() / JournalStorage::SECTOR_SIZE;
+  if (sectors_ < 2) {
+    return false;
+  }
+  // Jüngster und ältester beschriebener Sektor
+  bool found = false;
+  size_t oldest = 0;
+  uint32_t oldest_sequence = 0;
+  for (size_t sector = 0; sector < sectors_; sector++) {
+    SectorHeader header;
+    if (!storage->read(sector_offset_(sector), &header, sizeof(header)) || header.magic != SECTOR_MAGIC) {
+      continue;
+    }
+    if (!found || header.sequence > head_sequence_) {
+      head_sector_ = sector;
+      head_sequence_ = header.sequence;
+    }
+    if (!found || header.sequence < oldest_sequence) {
+      oldest = sector;
+      oldest_sequence = header.sequence;
+    }
+    found = true;
+  }
+  if (!found) {
+    head_sequence_ = 0;
+    pending_records_ = 0;
+    return open_sector_(0);
+  }
+
+  // Schreibposition: nach dem letzten vollständigen Eintrag des jüngsten Sektors
+  size_t offset = sizeof(SectorHeader);
+  RecordHeader header;
+  while (offset + sizeof(RecordHeader) <= JournalStorage::SECTOR_SIZE) {
+    if (!storage->read(sector_offset_(head_sector_) + offset, &header, sizeof(header))) {
+      break;
+    }
+    if (header.magic == 0xFFFF && header.length == 0xFFFF) {
+      break;  // gelöscht, hier geht es weiter
+    }
+    if (header.magic != RECORD_MAGIC || offset + sizeof(RecordHeader) + header.length > JournalStorage::SECTOR_SIZE ||
+        !record_valid_(head_sector_, offset, header)) {
+      // Beim Schreiben unterbrochen: der Sektor gilt als voll, der nächste Eintrag beginnt einen neuen.
+      // Ein lesbarer Kopf wird als übertragen markiert, damit der Eintrag nach dem nächsten Start nicht zählt.
+      stats_.corrupt_records++;
+      if (header.magic == RECORD_MAGIC && header.drained == 0xFF) {
+        static const uint8_t DRAINED = 0x00;
+        storage->write(sector_offset_(head_sector_) + offset + offsetof(RecordHeader, drained), &DRAINED, 1);
+      }
+      offset = JournalStorage::SECTOR_SIZE;
+      break;
+    }
+    offset += sizeof(RecordHeader) + header.length;
+  }
+  head_offset_ = offset;
+
+  // Noch nicht übertragene Einträge vom ältesten Sektor an zählen
+  tail_sector_ = oldest;
+  tail_offset_ = sizeof(SectorHeader);
+  pending_records_ = 0;
+  size_t sector = tail_sector_;
+  offset = tail_offset_;
+  while (next_record_(&sector, &offset, &header)) {
+    if (header.drained == 0xFF) {
+      pending_records_++;
+    }
+    offset += sizeof(RecordHeader) + header.length;
+  }
+  advance_tail_();
+  return true;
+}
+
+bool Journal::open_sector_(size_t sector) {
+  // Holt der Schreibkopf die Leseposition ein, gehen die Einträge des ältesten Sektors verloren
+  if (pending_records_ > 0 && tail_sector_ == sector) {
+    size_t offset = tail_offset_;
+    RecordHeader header;
+    while (read_record_(sector, offset, &header)) {
+      if (header.drained == 0xFF) {
+        stats_.records_dropped++;
+        pending_records_--;
+      }
+      offset += sizeof(RecordHeader) + header.length;
+    }
+    tail_sector_ = (sector + 1) % sectors_;
+    tail_offset_ = sizeof(SectorHeader);
+  }
+  if (!storage_->erase_sector(sector_offset_(sector))) {
+    return false;
+  }
+  stats_.sector_erases++;
+  SectorHeader header{SECTOR_MAGIC, ++head_sequence_};
+  if (!storage_->write(sector_offset_(sector), &header, sizeof(header))) {
+    return false;
+  }
+  stats_.programmed_bytes += sizeof(header);
+  head_sector_ = sector;
+  head_offset_ = sizeof(SectorHeader);
+  advance_tail_();
+  return true;
+}
+
+void Journal::advance_tail_() {
+  if (pending_records_ == 0) {
+    tail_sector_ = head_sector_;
+    tail_offset_ = head_offset_;
+    return;
+  }
+  RecordHeader header;
+  while (next_record_(&tail_sector_, &tail_offset_, &header) && header.drained != 0xFF) {
+    tail_offset_ += sizeof(RecordHeader) + header.length;
+  }
+}
+
+bool Journal::append(const JournalAnchor &anchor, const uint8_t *data, size_t length) {
+  if (storage_ == nullptr || length > max_record_size()) {
+    return false;
+  }
+  if (head_offset_ + sizeof(RecordHeader) + length > JournalStorage::SECTOR_SIZE &&
+      !open_sector_((head_sector_ + 1) % sectors_)) {
+    return false;
+  }
+  RecordHeader header{};
+  header.magic = RECORD_MAGIC;
+  header.drained = 0xFF;
+  header.reserved = 0xFF;
+  header.length = uint16_t(length);
+  header.anchor = anchor;
+  header.crc = crc16(crc16(0xFFFF, reinterpret_cast<const uint8_t *>(&anchor), sizeof(anchor)), data, length);
+  size_t position = sector_offset_(head_sector_) + head_offset_;
+  // Kopf zuerst: bricht das Schreiben ab, erkennt begin() den Eintrag an der falschen Prüfsumme
+  if (!storage_->write(position, &header, sizeof(header)) ||
+      !storage_->write(position + sizeof(header), data, length)) {
+    head_offset_ = JournalStorage::SECTOR_SIZE;
+    return false;
+  }
+  if (pending_records_ == 0) {
+    tail_sector_ = head_sector_;
+    tail_offset_ = head_offset_;
+  }
+  head_offset_ += sizeof(header) + length;
+  pending_records_++;
+  stats_.records_written++;
+  stats_.payload_bytes += length;
+  stats_.programmed_bytes += sizeof(header) + length;
+  return true;
+}
+
+bool Journal::read_batch(size_t max_bytes, JournalBatch *batch) {
+  batch->data.clear();
+  batch->records = 0;
+  if (pending_records_ == 0) {
+    return false;
+  }
+  size_t sector = tail_sector_;
+  size_t offset = tail_offset_;
+  RecordHeader header;
+  while (next_record_(&sector, &offset, &header)) {
+    if (header.drained == 0xFF) {
+      bool same_anchor =
+          header.anchor.millis == batch->anchor.millis && header.anchor.unix_time == batch->anchor.unix_time;
+      if (batch->records > 0 && (!same_anchor || batch->data.size() + header.length > max_bytes)) {
+        break;
+      }
+      size_t start = batch->data.size();
+      batch->data.resize(start + header.length);
+      if (!storage_->read(sector_offset_(sector) + offset + sizeof(RecordHeader), &batch->data[start],
+                          header.length)) {
+        batch->data.resize(start);
+        break;
+      }
+      batch->anchor = header.anchor;
+      batch->records++;
+    }
+    offset += sizeof(RecordHeader) + header.length;
+    batch->end_sector = sector;
+    batch->end_offset = offset;
+  }
+  return batch->records > 0;
+}
+
+void Journal::consume(const JournalBatch &batch) {
+  // Zwischen read_batch() und consume() darf nichts angehängt werden, sonst könnte der Sektor schon gelöscht sein
+  static const uint8_t DRAINED = 0x00;
+  RecordHeader header;
+  while (!(tail_sector_ == batch.end_sector && tail_offset_ >= batch.end_offset) &&
+         next_record_(&tail_sector_, &tail_offset_, &header)) {
+    if (header.drained == 0xFF) {
+      storage_->write(sector_offset_(tail_sector_) + tail_offset_ + offsetof(RecordHeader, drained), &DRAINED, 1);
+      stats_.programmed_bytes++;
+      stats_.records_drained++;
+      pending_records_--;
+    }
+    tail_offset_ += sizeof(RecordHeader) + header.length;
+  }
+  advance_tail_();
+}
+
+}  // namespace seplos_parser
+}  // namespace esphome
@@ -0,0 +1,128 @@
+#pragma once
+
+// Ringjournal im Flash für Upload-Abschnitte, die wegen fehlender Verbindung nicht gesendet werden konnten.
+// Reines C++ wie seplos_frame.h; der Flash-Zugriff läuft über JournalStorage.
+//
+// Aufbau: Sektoren werden streng reihum beschrieben, jeder beginnt mit {Kennung, laufende Nummer}. Einträge
+// werden nur angehängt und überspannen keine Sektorgrenze. Als übertragen markiert wird ein Eintrag, indem ein
+// Byte in seinem Kopf von 0xFF auf 0x00 gesetzt wird; NOR-Flash erlaubt das ohne Löschen. Gelöscht wird ein
+// Sektor also nur, wenn der Schreibkopf ihn wieder erreicht: jeder Sektor gleich oft, einmal je Umlauf.
+// Ist das Journal voll, wird der älteste Sektor samt nicht übertragener Einträge überschrieben.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef USE_ESP32
+#include <esp_partition.h>
+#endif
+
+namespace esphome {
+namespace seplos_parser {
+
+// Flash-Bereich; write() darf nur Bits von 1 auf 0 setzen, erase_sector() setzt einen Sektor auf 0xFF
+class JournalStorage {
+ public:
+  static const size_t SECTOR_SIZE = 4096;
+
+  virtual ~JournalStorage() = default;
+  virtual size_t size() const = 0;
+  virtual bool read(size_t offset, void *data, size_t length) = 0;
+  virtual bool write(size_t offset, const void *data, size_t length) = 0;
+  virtual bool erase_sector(size_t offset) = 0;
+};
+
+#ifdef USE_ESP32
+// Datenpartition aus der Partitionstabelle, über ihr Label gefunden
+class PartitionJournalStorage : public JournalStorage {
+ public:
+  // false, wenn es keine Partition mit diesem Label gibt
+  bool open(const char *label);
+  size_t size() const override;
+  bool read(size_t offset, void *data, size_t length) override;
+  bool write(size_t offset, const void *data, size_t length) override;
+  bool erase_sector(size_t offset) override;
+
+ protected:
+  const esp_partition_t *partition_{nullptr};
+};
+#endif
+
+// Zeitbezug eines Eintrags: millis() und Unix-Zeit (0 = unbekannt) zum selben Zeitpunkt
+struct JournalAnchor {
+  uint32_t millis;
+  uint32_t unix_time;
+};
+
+struct JournalStats {
+  uint32_t records_written{0};
+  uint32_t records_drained{0};
+  uint32_t records_dropped{0};  // überschrieben, bevor sie übertragen wurden
+  uint32_t corrupt_records{0};  // beim Start gefundene, unvollständig geschriebene Einträge
+  uint32_t sector_erases{0};
+  uint64_t payload_bytes{0};     // angehängte Nutzdaten
+  uint64_t programmed_bytes{0};  // insgesamt in den Flash geschriebene Bytes
+};
+
+// Zusammenhängende, noch nicht übertragene Einträge mit demselben Zeitbezug
+struct JournalBatch {
+  JournalAnchor anchor;
+  std::string data;  // Nutzdaten der Einträge hintereinander
+  uint16_t records{0};
+  size_t end_sector{0};
+  size_t end_offset{0};
+};
+
+class Journal {
+ public:
+  // Sektoren einlesen und Schreib- und Leseposition wiederherstellen; false, wenn der Bereich zu klein ist
+  bool begin(JournalStorage *storage);
+  bool append(const JournalAnchor &anchor, const uint8_t *data, size_t length);
+  // Ab der ältesten nicht übertragenen Stelle höchstens max_bytes Nutzdaten lesen; false, wenn nichts ansteht
+  bool read_batch(size_t max_bytes, JournalBatch *batch);
+  // Die Einträge eines mit read_batch() gelesenen Stapels als übertragen markieren
+  void consume(const JournalBatch &batch);
+
+  bool empty() const { return pending_records_ == 0; }
+  uint32_t pending_records() const { return pending_records_; }
+  size_t max_record_size() const;
+  const JournalStats &get_stats() const { return stats_; }
+
+ protected:
+  struct SectorHeader {
+    uint32_t magic;
+    uint32_t sequence;
+  };
+  struct RecordHeader {
+    uint16_t magic;
+    uint8_t drained;  // 0xFF = offen, 0x00 = übertragen
+    uint8_t reserved;
+    uint16_t length;
+    uint16_t crc;  // über Nutzdaten und Zeitbezug
+    JournalAnchor anchor;
+  };
+
+  size_t sector_offset_(size_t sector) const { return sector * JournalStorage::SECTOR_SIZE; }
+  // Kopf an dieser Stelle lesen; false, wenn dort kein Eintrag beginnt
+  bool read_record_(size_t sector, size_t offset, RecordHeader *header);
+  bool record_valid_(size_t sector, size_t offset, const RecordHeader &header);
+  // Ersten Eintrag ab der Position suchen, über Sektorgrenzen hinweg bis zum Schreibkopf
+  bool next_record_(size_t *sector, size_t *offset, RecordHeader *header);
+  bool open_sector_(size_t sector);
+  void advance_tail_();
+
+  JournalStorage *storage_{nullptr};
+  size_t sectors_{0};
+  // Schreibkopf
+  size_t head_sector_{0};
+  size_t head_offset_{0};
+  uint32_t head_sequence_{0};
+  // Älteste Stelle, die noch nicht übertragene Einträge enthalten kann
+  size_t tail_sector_{0};
+  size_t tail_offset_{0};
+  uint32_t pending_records_{0};
+  JournalStats stats_;
+};
+
+}  // namespace seplos_parser
+}  // namespace esphome
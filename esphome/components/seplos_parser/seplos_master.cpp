@@ -0,0 +1,186 @@
+#include "seplos_master.h"
+#include "seplos_frame.h"
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace seplos_parser {
+
+// Fehlende Packs werden mit wachsendem Abstand weiter abgefragt, höchstens so selten
+static const uint32_t MAX_BACKOFF_US = 60000000;
+
+void PollScheduler::configure(int bms_count, uint32_t baud_rate, uint32_t now) {
+  baud_rate_ = baud_rate;
+  // t3.5 wie beim Pausen-Framing; oberhalb von 19200 Baud fest 1750 µs
+  frame_gap_us_ = baud_rate > 19200 ? 1750 : 38500000UL / baud_rate;
+  entries_.clear();
+  for (int bms = 0; bms < bms_count; bms++) {
+    for (int block = 0; block < BLOCK_COUNT; block++) {
+      entries_.push_back({uint8_t(bms), static_cast<BlockId>(block), now, 0, false});
+    }
+  }
+  alarm_active_.assign(bms_count, false);
+  max_cost_us_ = 0;
+  for (const BlockDescriptor &block : BLOCKS) {
+    max_cost_us_ = std::max(max_cost_us_, cost_(block));
+  }
+  credit_us_ = 0;
+  credit_time_ = now;
+  in_flight_ = false;
+  retry_pending_ = false;
+  bus_free_at_ = now;
+}
+
+uint32_t PollScheduler::cost_(const BlockDescriptor &block) const {
+  return airtime(POLL_REQUEST_SIZE + RESPONSE_HEADER_SIZE + 2 + expected_byte_count(block.function, block.count));
+}
+
+uint32_t PollScheduler::interval_(const Entry &entry) const {
+  if (entry.block == BLOCK_PIC && alarm_active_[entry.bms_index]) {
+    return std::min(alarm_interval_, intervals_[BLOCK_PIC]);
+  }
+  return intervals_[entry.block];
+}
+
+void PollScheduler::request_soon(int bms_index, BlockId block) {
+  size_t index = size_t(bms_index) * BLOCK_COUNT + block;
+  if (index < entries_.size()) {
+    entries_[index].soon = true;
+  }
+}
+
+void PollScheduler::set_alarm_active(int bms_index, bool active) {
+  if (bms_index < 0 || size_t(bms_index) >= alarm_active_.size() || alarm_active_[bms_index] == active) {
+    return;
+  }
+  alarm_active_[bms_index] = active;
+  if (active) {
+    request_soon(bms_index, BLOCK_PIC);
+  }
+}
+
+void PollScheduler::build_request_(const Entry &entry, PollRequest *request) const {
+  const BlockDescriptor &block = BLOCKS[entry.block];
+  uint8_t *frame = request->frame;
+  frame[0] = entry.bms_index + 1;
+  frame[1] = block.function;
+  frame[2] = block.start >> 8;
+  frame[3] = block.start & 0xFF;
+  frame[4] = block.count >> 8;
+  frame[5] = block.count & 0xFF;
+  uint16_t crc = calculate_modbus_crc(frame, 6);
+  frame[6] = crc & 0xFF;
+  frame[7] = crc >> 8;
+  request->bms_index = entry.bms_index;
+  request->block = entry.block;
+}
+
+bool PollScheduler::next_request(uint32_t now, PollRequest *request) {
+  if (entries_.empty()) {
+    return false;
+  }
+  // Guthaben auffüllen; mindestens eine teuerste Abfrage, sonst bliebe bei kleinem Budget und niedriger Baudrate
+  // die überfälligste Abfrage für immer zu teuer und hielte alle anderen auf
+  uint32_t capacity = std::max(uint32_t(budget_ * 1000000.0f), max_cost_us_);
+  credit_us_ = uint32_t(std::min<uint64_t>(capacity, credit_us_ + uint64_t((now - credit_time_) * budget_)));
+  credit_time_ = now;
+
+  if (in_flight_) {
+    if (int32_t(now - deadline_) < 0) {
+      return false;
+    }
+    stats_.timeouts++;
+    in_flight_ = false;
+    bus_free_at_ = now;
+    if (attempts_ <= retries_) {
+      retry_pending_ = true;
+    } else {
+      finish_(now, false);
+    }
+  }
+  if (int32_t(now - bus_free_at_) < 0) {
+    return false;
+  }
+
+  size_t index = current_;
+  if (!retry_pending_) {
+    // Vorgezogene zuerst, sonst die gemessen an ihrem Takt am weitesten überfällige: reicht das Budget nicht,
+    // werden alle Takte um denselben Faktor gestreckt statt der schnelle Block auf den langsamen gebremst
+    bool found = false;
+    float latest = 0.0f;
+    for (size_t i = 0; i < entries_.size(); i++) {
+      const Entry &entry = entries_[i];
+      int32_t overdue = int32_t(now - entry.due);
+      if (!entry.soon && overdue < 0) {
+        continue;
+      }
+      float lateness = entry.soon ? INFINITY : float(overdue) / float(interval_(entry));
+      if (!found || lateness > latest) {
+        found = true;
+        latest = lateness;
+        index = i;
+      }
+    }
+    if (!found) {
+      return false;
+    }
+  }
+
+  uint32_t cost = cost_(BLOCKS[entries_[index].block]);
+  if (credit_us_ < cost) {
+    return false;
+  }
+  credit_us_ -= cost;
+  stats_.airtime_us += cost;
+  stats_.requests++;
+  if (!retry_pending_) {
+    attempts_ = 0;
+  }
+  attempts_++;
+  retry_pending_ = false;
+  current_ = index;
+  in_flight_ = true;
+  deadline_ = now + cost + timeout_us_;
+  build_request_(entries_[index], request);
+  return true;
+}
+
+void PollScheduler::on_response(uint32_t now, uint8_t address, bool exception) {
+  if (!in_flight_ || address != entries_[current_].bms_index + 1) {
+    return;
+  }
+  if (exception) {
+    stats_.exceptions++;
+  } else {
+    stats_.responses++;
+  }
+  in_flight_ = false;
+  bus_free_at_ = now + frame_gap_us_;
+  // Auch eine Ausnahme ist eine Antwort: der Pack ist da, eine Wiederholung brächte nichts
+  finish_(now, true);
+}
+
+void PollScheduler::finish_(uint32_t now, bool success) {
+  Entry &entry = entries_[current_];
+  entry.soon = false;
+  retry_pending_ = false;
+  uint32_t interval = interval_(entry);
+  if (success) {
+    entry.failures = 0;
+    // Fester Takt ab dem geplanten Zeitpunkt; wer zurückliegt, holt nicht mehrfach nach
+    entry.due += interval;
+    if (int32_t(now - entry.due) > 0) {
+      entry.due = now;
+    }
+    return;
+  }
+  stats_.failures++;
+  if (entry.failures < 16) {
+    entry.failures++;
+  }
+  uint64_t backoff = uint64_t(interval) << std::min<uint8_t>(entry.failures, 6);
+  entry.due = now + uint32_t(std::min<uint64_t>(backoff, MAX_BACKOFF_US));
+}
+
+}  // namespace seplos_parser
+}  // namespace esphome
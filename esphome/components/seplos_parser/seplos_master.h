@@ -0,0 +1,103 @@
+#pragma once
+
+// Aktiver Modbus-Master für kleine Anlagen ohne Seplos-Master auf dem Bus: der Planer entscheidet bei jedem
+// loop(), ob und welche Leseanfrage jetzt gesendet wird. Jeder Registerblock hat seinen eigenen Takt, die
+// Belegung des Busses bleibt unter einem Budget, Zeitüberschreitungen und Wiederholungen laufen ohne Warten ab.
+// Reines C++ wie seplos_frame.h; tools/seplos_master_sim.cpp betreibt ihn gegen einen simulierten Slave.
+//
+// Alle Zeiten in µs (micros()); Differenzen bleiben über den Überlauf hinweg richtig.
+
+#include "seplos_registers.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace seplos_parser {
+
+static const size_t POLL_REQUEST_SIZE = 8;
+
+struct PollRequest {
+  uint8_t bms_index;
+  BlockId block;
+  uint8_t frame[POLL_REQUEST_SIZE];  // Adresse, Funktion, Start, Anzahl, CRC
+};
+
+struct PollStats {
+  uint32_t requests{0};    // gesendete Anfragen einschließlich Wiederholungen
+  uint32_t responses{0};
+  uint32_t exceptions{0};
+  uint32_t timeouts{0};
+  uint32_t failures{0};    // nach allen Wiederholungen unbeantwortet
+  uint64_t airtime_us{0};  // Summe der Bus-Belegung durch Anfrage und erwartete Antwort
+};
+
+class PollScheduler {
+ public:
+  // Alle Setter vor configure()
+  void set_interval(BlockId block, uint32_t interval_us) { intervals_[block] = interval_us; }
+  // Alarmblock in diesem Takt, solange bei einem Pack ein Alarm ansteht
+  void set_alarm_interval(uint32_t interval_us) { alarm_interval_ = interval_us; }
+  void set_bus_budget(float fraction) { budget_ = fraction; }
+  // Wartezeit auf den Beginn der Antwort, zusätzlich zur Übertragungsdauer
+  void set_timeout(uint32_t timeout_us) { timeout_us_ = timeout_us; }
+  void set_retries(uint8_t retries) { retries_ = retries; }
+  void configure(int bms_count, uint32_t baud_rate, uint32_t now);
+
+  // Nächste zu sendende Anfrage, falls der Bus frei ist, das Budget reicht und eine fällig ist
+  bool next_request(uint32_t now, PollRequest *request);
+  // Antwort oder Ausnahme von address auf die laufende Anfrage; andere Frames werden ignoriert
+  void on_response(uint32_t now, uint8_t address, bool exception);
+  // Block bei der nächsten Gelegenheit abfragen (z. B. Alarme nach einem Stromsprung)
+  void request_soon(int bms_index, BlockId block);
+  void set_alarm_active(int bms_index, bool active);
+
+  bool busy() const { return in_flight_; }
+  uint32_t get_interval(BlockId block) const { return intervals_[block]; }
+  float get_bus_budget() const { return budget_; }
+  const PollStats &get_stats() const { return stats_; }
+  // Übertragungsdauer von n Zeichen zu 11 Bit
+  uint32_t airtime(size_t bytes) const { return uint32_t(bytes * 11ULL * 1000000ULL / baud_rate_); }
+
+ protected:
+  struct Entry {
+    uint8_t bms_index;
+    BlockId block;
+    uint32_t due;
+    uint8_t failures;  // aufeinanderfolgende, für den Rückzug bei fehlendem Pack
+    bool soon;
+  };
+
+  uint32_t interval_(const Entry &entry) const;
+  // Busbelegung durch Anfrage und erwartete Antwort
+  uint32_t cost_(const BlockDescriptor &block) const;
+  void finish_(uint32_t now, bool success);
+  void build_request_(const Entry &entry, PollRequest *request) const;
+
+  uint32_t intervals_[BLOCK_COUNT]{1000000, 5000000, 10000000};
+  uint32_t alarm_interval_{1000000};
+  float budget_{0.5f};
+  uint32_t timeout_us_{200000};
+  uint8_t retries_{2};
+  uint32_t baud_rate_{9600};
+  uint32_t frame_gap_us_{4010};  // t3.5 zwischen Antwort und nächster Anfrage
+
+  std::vector<Entry> entries_;
+  std::vector<bool> alarm_active_;
+  // Budget als Guthaben an Busbelegung: wächst mit budget_ je µs, höchstens eine Sekunde lang angespart, aber
+  // immer genug für die teuerste Abfrage
+  uint32_t credit_us_{0};
+  uint32_t max_cost_us_{0};
+  uint32_t credit_time_{0};
+
+  bool in_flight_{false};
+  bool retry_pending_{false};  // Zeitüberschreitung, dieselbe Anfrage geht erneut hinaus
+  size_t current_{0};  // Index in entries_
+  uint8_t attempts_{0};
+  uint32_t deadline_{0};
+  uint32_t bus_free_at_{0};  // frühester Sendezeitpunkt nach der letzten Antwort
+  PollStats stats_;
+};
+
+}  // namespace seplos_parser
+}  // namespace esphome
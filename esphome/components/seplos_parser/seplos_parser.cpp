@@ -2,8 +2,20 @@
 #include "esphome/core/log.h"
 #include "esphome/components/uart/uart.h"
 #include "esphome/core/helpers.h"
-#include <unordered_map>
-#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+#ifdef USE_SEPLOS_UPLINK
+#include "esphome/components/network/util.h"
+#endif
+
+#if defined(USE_ESP32)
+#include <esp_heap_caps.h>
+#elif defined(USE_ESP8266)
+#include <Esp.h>
+#endif
 
 namespace esphome {
 namespace seplos_parser {
@@ -11,402 +23,1140 @@ namespace seplos_parser {
 static const char *TAG = "seplos_parser.component";
 
 void SeplosParser::setup() {
-   // Initialisierung der Sensorvektoren
-   std::vector<std::vector<sensor::Sensor *> *> sensor_vectors = {
-       &pack_voltage_, &current_, &remaining_capacity_, &total_capacity_,
-       &total_discharge_capacity_, &soc_, &soh_, &cycle_count_,
-       &average_cell_voltage_, &average_cell_temp_, &max_cell_voltage_,
-       &min_cell_voltage_, &max_cell_temp_, &min_cell_temp_,
-       &maxdiscurt_, &maxchgcurt_, &cell_1_, &cell_2_, &cell_3_, &cell_4_,
-       &cell_5_, &cell_6_, &cell_7_, &cell_8_, &cell_9_, &cell_10_,
-       &cell_11_, &cell_12_, &cell_13_, &cell_14_, &cell_15_, &cell_16_,
-       &cell_temp_1_, &cell_temp_2_, &cell_temp_3_, &cell_temp_4_,
-       &case_temp_, &power_temp_
-   };
-
-   for (auto *vec : sensor_vectors) {
-       vec->resize(bms_count_, nullptr);
-   }
-
-   std::vector<std::vector<text_sensor::TextSensor *> *> text_sensor_vectors = {
-       &system_status_, &active_balancing_cells_, &cell_temperature_alarms_,
-       &cell_voltage_alarms_, &FET_status_, &active_alarms_, &active_protections_
-   };
-
-   for (auto *vec : text_sensor_vectors) {
-       vec->resize(bms_count_, nullptr);
-   }
-
-   // Zuordnung der Sensornamen zu den jeweiligen Vektoren
-   std::unordered_map<std::string, std::vector<sensor::Sensor *> *> sensor_map = {
-       {"pack_voltage", &pack_voltage_}, {"current", &current_},
-       {"remaining_capacity", &remaining_capacity_}, {"total_capacity", &total_capacity_},
-       {"total_discharge_capacity", &total_discharge_capacity_}, {"soc", &soc_},
-       {"soh", &soh_}, {"cycle_count", &cycle_count_}, {"average_cell_voltage", &average_cell_voltage_},
-       {"average_cell_temp", &average_cell_temp_}, {"max_cell_voltage", &max_cell_voltage_},
-       {"min_cell_voltage", &min_cell_voltage_}, {"max_cell_temp", &max_cell_temp_},
-       {"min_cell_temp", &min_cell_temp_}, {"maxdiscurt", &maxdiscurt_},
-       {"maxchgcurt", &maxchgcurt_}, {"cell_1", &cell_1_}, {"cell_2", &cell_2_},
-       {"cell_3", &cell_3_}, {"cell_4", &cell_4_}, {"cell_5", &cell_5_},
-       {"cell_6", &cell_6_}, {"cell_7", &cell_7_}, {"cell_8", &cell_8_},
-       {"cell_9", &cell_9_}, {"cell_10", &cell_10_}, {"cell_11", &cell_11_},
-       {"cell_12", &cell_12_}, {"cell_13", &cell_13_}, {"cell_14", &cell_14_},
-       {"cell_15", &cell_15_}, {"cell_16", &cell_16_}, {"cell_temp_1", &cell_temp_1_},
-       {"cell_temp_2", &cell_temp_2_}, {"cell_temp_3", &cell_temp_3_},
-       {"cell_temp_4", &cell_temp_4_}, {"case_temp", &case_temp_},
-       {"power_temp", &power_temp_}
-   };
-
-   std::unordered_map<std::string, std::vector<text_sensor::TextSensor *> *> text_sensor_map = {
-       {"system_status", &system_status_}, {"active_balancing_cells", &active_balancing_cells_},
-       {"cell_temperature_alarms", &cell_temperature_alarms_}, {"cell_voltage_alarms", &cell_voltage_alarms_},
-       {"FET_status", &FET_status_}, {"active_alarms", &active_alarms_},
-       {"active_protections", &active_protections_}
-   };
-
-   // Zuordnung der Sensor-Objekte
-   for (auto &entry : sensor_map) {
-       const std::string &name = entry.first;
-       std::vector<sensor::Sensor *> *sensor_vector = entry.second;
-
-       for (int i = 0; i < bms_count_; i++) {
-           std::string expected_name = "bms" + std::to_string(i) + " " + name;
-           for (auto *sensor : this->sensors_) {
-               if (sensor->get_name() == expected_name) {
-                   (*sensor_vector)[i] = sensor;
-               }
-           }
-       }
-   }
-
-   // Zuordnung der Text-Sensor-Objekte
-   for (auto &entry : text_sensor_map) {
-       const std::string &name = entry.first;
-       std::vector<text_sensor::TextSensor *> *text_sensor_vector = entry.second;
-
-       for (int i = 0; i < bms_count_; i++) {
-           std::string expected_name = "bms" + std::to_string(i) + " " + name;
-           for (auto *sensor : this->text_sensors_) {
-               if (sensor->get_name() == expected_name) {
-                   (*text_sensor_vector)[i] = sensor;
-               }
-           }
-       }
-   }
+  text_buffer_.reserve(512);
+  for (auto &values : last_published_value_) {
+    for (float &value : values) {
+      value = NAN;
+    }
+  }
+  for (auto &values : field_values_) {
+    for (float &value : values) {
+      value = NAN;
+    }
+  }
+  for (float &value : bank_last_value_) {
+    value = NAN;
+  }
+  for (float &value : master_current_) {
+    value = NAN;
+  }
+  if (buses_.empty()) {
+    set_bms_count(1);
+  }
+  buses_[0].uart = parent_;
+  if (gap_framing_) {
+    for (Bus &bus : buses_) {
+      // t3.5 = 3,5 Zeichen zu 11 Bit; oberhalb von 19200 Baud schreibt Modbus feste 1750 µs vor
+      uint32_t baud_rate = bus.uart->get_baud_rate();
+      bus.frame_gap_us = frame_gap_us_ != 0 ? frame_gap_us_ : baud_rate > 19200 ? 1750 : 38500000UL / baud_rate;
+      bus.scanner.set_gap_framing(true);
+    }
+    // Pausen lassen sich nur so fein erkennen, wie loop() aufgerufen wird
+    high_freq_.start();
+  }
+#ifdef USE_BINARY_SENSOR
+  for (auto *sensor : online_sensors_) {
+    if (sensor != nullptr) {
+      sensor->publish_state(false);
+    }
+  }
+#endif
+  // Energiezähler über Neustarts hinweg fortführen; ESPHome schreibt erst nach flash_write_interval in den Flash
+  energy_preferences_.reserve(bms_count_);
+  for (int i = 0; i < bms_count_; i++) {
+    EnergyCounter &energy = pack_statistics_[i].energy;
+    energy.set_max_gap(stale_timeout_);
+    uint32_t key = fnv1_hash("seplos_energy_" + preference_key_ + "_" + to_string(i));
+    energy_preferences_.push_back(global_preferences->make_preference<EnergyState>(key));
+    if (restore_energy_) {
+      energy_preferences_[i].load(&energy.state());
+    }
+  }
+  if (capture_pre_trigger_ + capture_post_trigger_ > 0) {
+    captures_.resize(bms_count_);
+    for (auto &capture : captures_) {
+      capture.configure(capture_pre_trigger_, capture_post_trigger_);
+    }
+#ifdef USE_SEPLOS_CAPTURE_WEB
+    if (web_server_base::global_web_server_base != nullptr) {
+      web_server_base::global_web_server_base->init();
+      web_server_base::global_web_server_base->add_handler(new CaptureHandler(this));
+    }
+#endif
+  }
+  if (history_slots_ > 0 && !history_fields_.empty()) {
+    // Ein Block für alle Packs; RAMAllocator nimmt PSRAM, falls vorhanden, sonst internen RAM
+    size_t size = HistoryRing::storage_size(history_fields_.size(), history_slots_);
+    RAMAllocator<uint8_t> allocator;
+    uint8_t *storage = allocator.allocate(size * bms_count_);
+    if (storage == nullptr) {
+      ESP_LOGE(TAG, "Verlauf: %u Byte nicht verfügbar", (unsigned) (size * bms_count_));
+    } else {
+      histories_.resize(bms_count_);
+      for (int i = 0; i < bms_count_; i++) {
+        histories_[i].configure(&history_fields_, history_slots_, storage + i * size);
+      }
+      set_interval("history", 1000, [this]() { this->tick_history_(); });
+#ifdef USE_SEPLOS_HISTORY
+      if (web_server_base::global_web_server_base != nullptr) {
+        web_server_base::global_web_server_base->init();
+        web_server_base::global_web_server_base->add_handler(new HistoryHandler(this));
+      }
+#endif
+    }
+  }
+#ifdef USE_SEPLOS_UPLINK
+  if (uplink_http_ != nullptr) {
+    uplink_.configure(uplink_buffer_size_, bms_count_);
+#ifdef USE_ESP32
+    if (!journal_partition_.empty()) {
+      if (journal_storage_.open(journal_partition_.c_str()) && journal_.begin(&journal_storage_)) {
+        journal_ready_ = true;
+        ESP_LOGI(TAG, "Journal '%s': %u Einträge warten auf Upload", journal_partition_.c_str(),
+                 journal_.pending_records());
+      } else {
+        ESP_LOGE(TAG, "Journal-Partition '%s' fehlt oder ist kleiner als zwei Sektoren", journal_partition_.c_str());
+      }
+    }
+#endif
+    set_interval("uplink", uplink_flush_interval_, [this]() { this->flush_uplink_(); });
+  }
+#endif
+  if (master_) {
+    if (flow_control_pin_ != nullptr) {
+      flow_control_pin_->setup();
+      flow_control_pin_->digital_write(false);
+    }
+    scheduler_.configure(buses_[0].pack_count, parent_->get_baud_rate(), micros());
+  }
+  set_interval("statistics", update_interval_, [this]() { this->publish_statistics_(); });
+  set_interval("diagnostics", update_interval_, [this]() { this->publish_diagnostics_(); });
+  // Online-Sensoren gehen erst hier offline; online werden sie direkt beim Empfang
+  set_interval("staleness", 1000, [this]() { this->check_staleness_(); });
+}
+
+bool SeplosParser::is_stale(int bms_index, BlockId block) const {
+  uint32_t last_seen = last_seen_[bms_index][block];
+  return last_seen == 0 || millis() - last_seen > stale_timeout_;
 }
 
+bool SeplosParser::is_online(int bms_index) const {
+  if (bms_index < 0 || bms_index >= MAX_BMS_COUNT) {
+    return false;
+  }
+  for (int block = 0; block < BLOCK_COUNT; block++) {
+    if (!is_stale(bms_index, static_cast<BlockId>(block))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SeplosParser::check_staleness_() {
+  for (int i = 0; i < bms_count_ && i < MAX_BMS_COUNT; i++) {
+    if (online_[i] && !is_online(i)) {
+      ESP_LOGW(TAG, "BMS %d: seit %u s keine Antwort", i, stale_timeout_ / 1000);
+      update_online_(i, false);
+    }
+  }
+}
+
+void SeplosParser::update_online_(int bms_index, bool online) {
+  online_[bms_index] = online;
+  bank_.set_active(bms_index, online);
+  if (!online) {
+    publish_bank_();  // beim Wiederkommen folgt die Veröffentlichung mit dem ersten dekodierten Frame
+  }
+#ifdef USE_BINARY_SENSOR
+  if (online_sensors_[bms_index] != nullptr) {
+    online_sensors_[bms_index]->publish_state(online);
+  }
+#endif
+}
+
+void SeplosParser::publish_diagnostics_() {
+  sample_heap_();
+  FrameScannerStats stats = scanner_stats_();
+  const PollStats &poll = scheduler_.get_stats();
+  // Belegter Anteil der Buszeit seit der letzten Veröffentlichung in %
+  uint32_t elapsed_ms = millis() - last_rate_time_;
+  float utilization = elapsed_ms > 0 ? (poll.airtime_us - master_airtime_at_last_rate_) / (10.0f * elapsed_ms) : 0.0f;
+  master_airtime_at_last_rate_ = poll.airtime_us;
+  for (int field = 0; field < DIAGNOSTIC_COUNT; field++) {
+    sensor::Sensor *sensor = diagnostic_sensors_[field];
+    if (sensor == nullptr) {
+      continue;
+    }
+    float value = 0.0f;
+    switch (static_cast<DiagnosticField>(field)) {
+      case DIAG_UART_BACKLOG: value = uart_backlog_max_; break;
+      case DIAG_UART_OVERRUNS: value = uart_overruns_; break;
+      case DIAG_FRAMES_DEFERRED: value = frames_deferred_; break;
+      case DIAG_BYTES_RECEIVED: value = stats.bytes_received; break;
+      case DIAG_FRAMES: value = stats.frames; break;
+      case DIAG_FRAMES_PIA: value = frames_per_block_[BLOCK_PIA]; break;
+      case DIAG_FRAMES_PIB: value = frames_per_block_[BLOCK_PIB]; break;
+      case DIAG_FRAMES_PIC: value = frames_per_block_[BLOCK_PIC]; break;
+      case DIAG_CRC_ERRORS: value = stats.crc_errors; break;
+      case DIAG_RESYNC_BYTES: value = stats.resync_bytes; break;
+      case DIAG_EVICTED_BYTES: value = stats.evicted_bytes; break;
+      case DIAG_INVALID_BMS_IDS: value = invalid_bms_ids_; break;
+      case DIAG_LOOP_TIME_P50: value = loop_time_.quantile(0.5f); break;
+      case DIAG_LOOP_TIME_P99: value = loop_time_.quantile(0.99f); break;
+      case DIAG_LOOP_TIME_MAX: value = loop_time_.max; break;
+      case DIAG_PUBLISH_LATENCY_P50: value = publish_latency_.quantile(0.5f); break;
+      case DIAG_PUBLISH_LATENCY_P99: value = publish_latency_.quantile(0.99f); break;
+      case DIAG_PUBLISH_LATENCY_MAX: value = publish_latency_.max; break;
+      case DIAG_FREE_HEAP: value = free_heap_; break;
+      case DIAG_MIN_FREE_HEAP: value = min_free_heap_; break;
+#ifdef USE_SEPLOS_UPLINK
+      case DIAG_UPLINK_BUFFERED: value = uplink_.buffered_bytes(); break;
+      case DIAG_UPLINK_DROPPED: value = uplink_.dropped_chunks(); break;
+      case DIAG_UPLINK_FAILURES: value = uplink_failures_; break;
+      case DIAG_JOURNAL_PENDING: value = journal_.pending_records(); break;
+      case DIAG_JOURNAL_DROPPED: value = journal_.get_stats().records_dropped; break;
+#endif
+      case DIAG_MASTER_REQUESTS: value = poll.requests; break;
+      case DIAG_MASTER_TIMEOUTS: value = poll.timeouts; break;
+      case DIAG_MASTER_FAILURES: value = poll.failures; break;
+      case DIAG_BUS_UTILIZATION: value = utilization; break;
+      default: break;
+    }
+    sensor->publish_state(value);
+  }
+  // Frames pro Minute seit der letzten Veröffentlichung
+  uint32_t now = millis();
+  float minutes = (now - last_rate_time_) / 60000.0f;
+  last_rate_time_ = now;
+  for (int bms = 0; bms < bms_count_ && bms < MAX_BMS_COUNT; bms++) {
+    sensor::Sensor **sensors = pack_diagnostic_sensors_[bms];
+    uint32_t frames = frames_per_bms_[bms] - frames_at_last_rate_[bms];
+    frames_at_last_rate_[bms] = frames_per_bms_[bms];
+    if (sensors[PACK_DIAG_FRAMES] != nullptr) {
+      sensors[PACK_DIAG_FRAMES]->publish_state(frames_per_bms_[bms]);
+    }
+    if (sensors[PACK_DIAG_FRAME_RATE] != nullptr && minutes > 0.0f) {
+      sensors[PACK_DIAG_FRAME_RATE]->publish_state(frames / minutes);
+    }
+  }
+  // Rückstand und Zeitverteilungen gelten je Veröffentlichungsintervall, die Zähler laufen weiter
+  uart_backlog_max_ = 0;
+  loop_time_.reset();
+  publish_latency_.reset();
+}
+
+void SeplosParser::sample_heap_() {
+#if defined(USE_ESP32)
+  free_heap_ = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  min_free_heap_ = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+#elif defined(USE_ESP8266)
+  free_heap_ = ESP.getFreeHeap();  // NOLINT(readability-static-accessed-through-instance)
+  min_free_heap_ = min_free_heap_ == 0 ? free_heap_ : std::min(min_free_heap_, free_heap_);
+#endif
+}
+
+// Histogramm kompakt: "<Grenze>:<Anzahl>" nur für belegte Klassen
+static std::string format_histogram(const TimeHistogram &histogram) {
+  std::string out;
+  for (int i = 0; i < TimeHistogram::BUCKETS; i++) {
+    if (histogram.counts[i] == 0) {
+      continue;
+    }
+    if (i == TimeHistogram::BUCKETS - 1) {
+      out += str_sprintf(" >=%u:%u", 1u << (i - 1), histogram.counts[i]);
+    } else {
+      out += str_sprintf(" <%u:%u", 1u << i, histogram.counts[i]);
+    }
+  }
+  return out;
+}
 
 void SeplosParser::loop() {
-  while (available()) {
-    uint8_t byte = read();
-    buffer.push_back(byte);
+  uint32_t loop_start = micros();
+  if (flow_control_active_) {
+    release_flow_control_(loop_start);
+  }
+  drain_rx_(loop_start);
+  if (master_) {
+    poll_master_();
+  }
+  loop_time_.add(micros() - loop_start);
+}
+
+void SeplosParser::poll_master_() {
+  PollRequest request;
+  if (!scheduler_.next_request(micros(), &request)) {
+    return;
+  }
+  const BlockDescriptor &block = BLOCKS[request.block];
+  buses_[0].scanner.expect_response(request.frame[0], block.function, block.start, block.count);
+  if (flow_control_pin_ == nullptr) {
+    write_array(request.frame, POLL_REQUEST_SIZE);
+    return;
+  }
+  // Treiber erst nach dem letzten Stoppbit zurück auf Empfang. Statt mit flush() zu warten (~9 ms bei 9600 Baud),
+  // wird das Sendeende aus der Übertragungsdauer berechnet und in einer späteren loop() umgeschaltet; ein Zeichen
+  // Reserve deckt die Latenz zwischen write_array() und dem ersten Startbit ab.
+  flow_control_pin_->digital_write(true);
+  write_array(request.frame, POLL_REQUEST_SIZE);
+  flow_control_release_at_ = micros() + scheduler_.airtime(POLL_REQUEST_SIZE + 1);
+  flow_control_active_ = true;
+  tx_high_freq_.start();
+}
 
-    if (buffer.size() > 100) {
-      buffer.pop_front();
+void SeplosParser::release_flow_control_(uint32_t now) {
+  if (int32_t(now - flow_control_release_at_) < 0) {
+    return;
+  }
+  flow_control_pin_->digital_write(false);
+  flow_control_active_ = false;
+  tx_high_freq_.stop();
+}
+
+void SeplosParser::update_master_alarm_(int bms_index, const uint8_t *bits) {
+  bool active = false;
+  for (const AlarmDescriptor &desc : ALARM_DESCRIPTORS) {
+    if ((desc.kind == ALARM_KIND_ALARM || desc.kind == ALARM_KIND_PROTECTION) &&
+        (bits[desc.byte - ALARM_FIRST_BYTE] & desc.mask)) {
+      active = true;
+      break;
     }
-   
-    if (buffer.size() >= 5) {
-      if (!is_valid_header()) {
-        buffer.pop_front();
-        continue;
+  }
+  scheduler_.set_alarm_active(bms_index, active);
+}
+
+void SeplosParser::drain_rx_(uint32_t loop_start) {
+  size_t count = buses_.size();
+  for (size_t i = 0; i < count; i++) {
+    if (!drain_bus_((next_bus_ + i) % count, loop_start)) {
+      break;
+    }
+  }
+  next_bus_ = (next_bus_ + 1) % count;
+}
+
+bool SeplosParser::drain_bus_(int bus_index, uint32_t loop_start) {
+  Bus &bus = buses_[bus_index];
+  FrameScanner &scanner = bus.scanner;
+  size_t available_bytes = bus.uart->available();
+  uart_backlog_max_ = std::max(uart_backlog_max_, available_bytes);
+  if (available_bytes >= bus.uart->get_rx_buffer_size()) {
+    uart_overruns_++;  // Puffer voll: weitere Bytes hat der Treiber verworfen
+  }
+  if (gap_framing_) {
+    // Zwischen zwei Lesevorgängen ohne neue Bytes mindestens t3.5 still: der Abschnitt ist zu Ende
+    if (available_bytes > 0) {
+      bus.last_rx_us = loop_start;
+    } else if (scanner.pending() > 0 && loop_start - bus.last_rx_us >= bus.frame_gap_us) {
+      scanner.mark_gap();
+    }
+  }
+
+  if (bus.has_deferred_frame) {
+    bus.has_deferred_frame = false;
+    process_packet(bus.deferred_frame, bus_index);
+    publish_latency_.add(micros() - bus.deferred_arrival_us);
+  }
+
+  // Den ganzen Rückstand abarbeiten, solange das Zeitbudget reicht
+  while (true) {
+    size_t space;
+    uint8_t *dest = scanner.prepare_write(&space);
+    size_t chunk = std::min(available_bytes, space);
+    // Ankunftszeit = Zeitpunkt des Lesevorgangs, der den Frame vervollständigt hat
+    uint32_t arrival_us = micros();
+    if (chunk > 0) {
+      bus.uart->read_array(dest, chunk);
+      scanner.commit_write(chunk);
+      available_bytes -= chunk;
+    }
+
+    ModbusFrame frame;
+    while (scanner.next_frame(&frame)) {
+      if (master_ && bus_index == 0 && frame.kind != FRAME_REQUEST) {
+        scheduler_.on_response(arrival_us, frame.data[0], frame.kind == FRAME_EXCEPTION);
+      }
+      if (frame.kind != FRAME_RESPONSE) {
+        continue;  // Anfragen merkt sich der Scanner zum Paaren, Ausnahmen tragen keine Messwerte
+      }
+      if (micros() - loop_start >= loop_budget_us_) {
+        bus.deferred_frame = frame;
+        bus.deferred_arrival_us = arrival_us;
+        bus.has_deferred_frame = true;
+        frames_deferred_++;
+        return false;
       }
+      process_packet(frame, bus_index);
+      publish_latency_.add(micros() - arrival_us);
+    }
+
+    // Restliche Bytes bleiben im UART-Puffer und werden beim nächsten Aufruf gelesen
+    if (micros() - loop_start >= loop_budget_us_) {
+      return false;
+    }
+    if (available_bytes == 0) {
+      return true;
+    }
+  }
+}
+
+FrameScannerStats SeplosParser::scanner_stats_() const {
+  FrameScannerStats total;
+  for (const Bus &bus : buses_) {
+    const FrameScannerStats &stats = bus.scanner.get_stats();
+    total.bytes_received += stats.bytes_received;
+    total.frames += stats.frames;
+    total.requests += stats.requests;
+    total.unpaired_responses += stats.unpaired_responses;
+    total.crc_errors += stats.crc_errors;
+    total.resync_bytes += stats.resync_bytes;
+    total.evicted_bytes += stats.evicted_bytes;
+    total.gap_frames += stats.gap_frames;
+    total.gap_fallbacks += stats.gap_fallbacks;
+    total.gap_splits += stats.gap_splits;
+  }
+  return total;
+}
+
+void SeplosParser::process_packet(const ModbusFrame &frame, int bus_index) {
+  const uint8_t *data = frame.data;
+  const Bus &bus = buses_[bus_index];
+  int address_index = data[0] - 0x01;
+  if (address_index < 0 || address_index >= bus.pack_count) {
+    invalid_bms_ids_++;
+    ESP_LOGW("seplos", "Bus %d: ungültige BMS-ID: %d", bus_index, data[0]);
+    return;
+  }
+  int bms_index = bus.first_pack + address_index;
+  frames_per_bms_[bms_index]++;
 
-      size_t expected_length = get_expected_length();
-      if (buffer.size() >= expected_length) {
-        if (validate_crc(expected_length)) {
-          process_packet(expected_length);
-          //buffer.clear();
-          buffer.erase(buffer.begin(), buffer.begin() + expected_length);
-          return;  // Nach dem Verarbeiten eines Pakets direkt aus der loop() aussteigen
-        } 
-        else {
-          buffer.pop_front();
+  // Gepaarte Antworten werden über Startadresse und Umfang der Anfrage zugeordnet,
+  // ungepaarte nur, wenn ihre Länge genau einem vollständigen Block entspricht
+  const BlockDescriptor *block;
+  uint16_t start, count;
+  if (frame.paired) {
+    block = find_block(data[1], frame.start, frame.count);
+    start = frame.start;
+    count = frame.count;
+  } else {
+    block = find_block_by_shape(data[1], data[2]);
+    start = block != nullptr ? block->start : 0;
+    count = block != nullptr ? block->count : 0;
+  }
+  if (block == nullptr) {
+    ESP_LOGV(TAG, "Unbekannter Block: Funktion 0x%02X, Start 0x%04X, %u Datenbytes", data[1], start, data[2]);
+    return;
+  }
+
+  frames_per_block_[block->id]++;
+  // 0 bleibt "noch nie empfangen" vorbehalten
+  last_seen_[bms_index][block->id] = std::max<uint32_t>(millis(), 1);
+  if (!online_[bms_index]) {
+    update_online_(bms_index, true);
+  }
+  if (!captures_.empty() && block->id != BLOCK_PIC && start == block->start && count == block->count) {
+    LockGuard guard{capture_lock_};
+    captures_[bms_index].add(millis(), block->id, data + RESPONSE_HEADER_SIZE, data[2]);
+  }
+#ifdef USE_SEPLOS_UPLINK
+  // Nur vollständige Blöcke, damit jeder Eintrag dieselben Worte trägt
+  if (uplink_http_ != nullptr && start == block->start && count == block->count) {
+    record_uplink_(bms_index, block->id, data);
+  }
+#endif
+  if (block->id == BLOCK_PIC) {
+    process_alarm_frame_(data + ALARM_FIRST_BYTE, bms_index);
+    publish_packed_(bms_index, BLOCK_PIC);
+  } else {
+    publish_fields_(*block, data, bms_index, start - block->start, count);
+    publish_packed_(bms_index, block->id);
+    if (!histories_.empty()) {
+      LockGuard guard{history_lock_};
+      histories_[bms_index].add(millis(), block->id, field_values_[bms_index]);
+    }
+    update_bank_(bms_index, block->id);
+    if (block->id == BLOCK_PIA) {
+      update_statistics_(bms_index);
+      if (master_) {
+        // Stromsprung oder Richtungswechsel: Alarme nicht erst im nächsten regulären Takt lesen
+        float current = field_values_[bms_index][SENSOR_CURRENT];
+        float &last = master_current_[bms_index];
+        if (!std::isnan(current) && !std::isnan(last) &&
+            (fabsf(current - last) >= 10.0f || (current > 1.0f && last < -1.0f) || (current < -1.0f && last > 1.0f))) {
+          scheduler_.request_soon(bms_index, BLOCK_PIC);
+        }
+        if (!std::isnan(current)) {
+          last = current;
         }
       }
+    } else {
+      pack_statistics_[bms_index].cells.add_cells(millis(), field_values_[bms_index] + SENSOR_CELL_1,
+                                                  SENSOR_CELL_16 - SENSOR_CELL_1 + 1);
     }
   }
 }
 
-bool SeplosParser::is_valid_header() {
-  return ((buffer[0] >= 0x01 && buffer[0] <= 0x10 && buffer[1] == 0x04 && (buffer[2] == 0x24 || buffer[2] == 0x34)) ||
-         (buffer[0] >= 0x01 && buffer[0] <= 0x10 && buffer[1] == 0x01 && buffer[2] == 0x12));
+void SeplosParser::update_bank_(int bms_index, BlockId block) {
+  const float *values = field_values_[bms_index];
+  if (block == BLOCK_PIA) {
+    static const SensorField needed[] = {SENSOR_PACK_VOLTAGE,  SENSOR_CURRENT, SENSOR_REMAINING_CAPACITY,
+                                         SENSOR_TOTAL_CAPACITY, SENSOR_SOC,     SENSOR_MAX_CELL_VOLTAGE,
+                                         SENSOR_MIN_CELL_VOLTAGE};
+    for (SensorField field : needed) {
+      if (std::isnan(values[field])) {
+        return;  // Teilweise gelesener Block, der noch nicht alle Größen geliefert hat
+      }
+    }
+    bank_.update_pack(bms_index, values[SENSOR_PACK_VOLTAGE], values[SENSOR_CURRENT],
+                      values[SENSOR_REMAINING_CAPACITY], values[SENSOR_TOTAL_CAPACITY], values[SENSOR_SOC],
+                      values[SENSOR_MAX_CELL_VOLTAGE], values[SENSOR_MIN_CELL_VOLTAGE]);
+  } else if (block == BLOCK_PIB) {
+    bank_.update_cells(bms_index, values + SENSOR_CELL_1, SENSOR_CELL_16 - SENSOR_CELL_1 + 1);
+  }
+  publish_bank_();
 }
-size_t SeplosParser::get_expected_length() {
-  // +3 Header, +2 CRC, =+5
-  if (buffer[2] == 0x24) {return 41;} // (0x24) 36+5=41
-  if (buffer[2] == 0x34) {return 57;} // (0x34) 52+5=57
-  if (buffer[1] == 0x01 && buffer[2] == 0x12) {return 23;} // (0x12) 18+5=23
-  return 0; // If an invalid packet arrives
+
+void SeplosParser::update_statistics_(int bms_index) {
+  const float *values = field_values_[bms_index];
+  float sample[STAT_QUANTITY_COUNT] = {values[SENSOR_CURRENT], values[SENSOR_PACK_VOLTAGE],
+                                       values[SENSOR_MAX_CELL_VOLTAGE] - values[SENSOR_MIN_CELL_VOLTAGE]};
+  PackStatistics &stats = pack_statistics_[bms_index];
+  uint32_t now = millis();
+  for (int quantity = 0; quantity < STAT_QUANTITY_COUNT; quantity++) {
+    if (std::isnan(sample[quantity])) {
+      continue;
+    }
+    for (auto &window : stats.windows[quantity]) {
+      window.add(now, sample[quantity]);
+    }
+  }
+  stats.cells.add_current(now, values[SENSOR_CURRENT]);
+  // Mit jedem Frame (~200 ms) integriert, nicht nur mit den veröffentlichten Werten
+  if (!std::isnan(values[SENSOR_CURRENT]) && !std::isnan(values[SENSOR_PACK_VOLTAGE])) {
+    stats.energy.add_sample(now, values[SENSOR_PACK_VOLTAGE], values[SENSOR_CURRENT]);
+  }
 }
-bool SeplosParser::validate_crc(size_t length) {
-  uint16_t received_crc = (buffer[length - 1] << 8) | buffer[length - 2];
-  uint16_t calculated_crc = calculate_modbus_crc(buffer, length - 2);
-  return received_crc == calculated_crc;
+
+// Kalendertag aus time_id. Ohne gültige Uhrzeit (kein time_id oder noch nicht synchronisiert) bleibt der
+// wiederhergestellte Tag stehen, statt die Tageszähler nach jedem Neustart auf einen Laufzeit-Tag umzustellen
+uint32_t SeplosParser::current_day_() {
+#ifdef USE_TIME
+  if (time_ != nullptr) {
+    ESPTime now = time_->now();
+    if (now.is_valid()) {
+      return now.year * 1000u + now.day_of_year;
+    }
+  }
+#endif
+  return 0;
 }
 
-std::string join_list(const std::vector<int>& list, const std::string& delimiter = ", ") {
-  if (list.empty()) return "";
-  std::ostringstream oss;
-  for (size_t i = 0; i < list.size(); i++) {
-    if (i > 0) oss << delimiter;
-    oss << list[i];
+uint32_t SeplosParser::unix_time_() {
+#ifdef USE_TIME
+  if (time_ != nullptr) {
+    ESPTime now = time_->now();
+    if (now.is_valid()) {
+      return now.timestamp;
+    }
   }
-  return oss.str();
+#endif
+  return 0;
 }
 
-std::string join_list(const std::vector<std::string>& list, const std::string& delimiter = ", ") {
-  if (list.empty()) return "";
-  std::ostringstream oss;
-  for (size_t i = 0; i < list.size(); i++) {
-    if (i > 0) oss << delimiter;
-    oss << list[i];
+void SeplosParser::publish_statistics_() {
+  uint32_t now = millis();
+  uint32_t day = current_day_();
+  for (int i = 0; i < bms_count_; i++) {
+    if (day != 0) {
+      pack_statistics_[i].energy.start_day(day);
+    }
+    energy_preferences_[i].save(&pack_statistics_[i].energy.state());
+  }
+  for (auto &binding : statistic_bindings_) {
+    if (binding.bms_index >= pack_statistics_.size()) {
+      continue;
+    }
+    float value[STAT_AGGREGATION_COUNT];
+    const RollingWindow &window = pack_statistics_[binding.bms_index].windows[binding.quantity][binding.window];
+    if (window.get(now, &value[AGG_MIN], &value[AGG_MAX], &value[AGG_MEAN])) {
+      binding.sensor->publish_state(value[binding.aggregation]);
+    }
+  }
+  for (auto &binding : energy_bindings_) {
+    if (binding.bms_index < pack_statistics_.size()) {
+      binding.sensor->publish_state(pack_statistics_[binding.bms_index].energy.get(binding.field));
+    }
+  }
+  for (auto &binding : cell_bindings_) {
+    if (binding.bms_index >= pack_statistics_.size()) {
+      continue;
+    }
+    float value = pack_statistics_[binding.bms_index].cells.get(binding.field, binding.cell);
+    if (!std::isnan(value)) {
+      binding.sensor->publish_state(value);
+    }
   }
-  return oss.str();
 }
 
-void SeplosParser::process_packet(size_t length) {
-  int bms_index = buffer[0] - 0x01;
-  if (bms_index < 0 || bms_index >= bms_count_) {
-    ESP_LOGW("seplos", "Ungültige BMS-ID: %d", buffer[0]);
+void SeplosParser::on_shutdown() {
+#ifdef USE_SEPLOS_UPLINK
+  spill_uplink_();
+#endif
+  for (size_t i = 0; i < energy_preferences_.size(); i++) {
+    energy_preferences_[i].save(&pack_statistics_[i].energy.state());
+  }
+}
+
+#ifdef USE_SEPLOS_UPLINK
+void SeplosParser::record_uplink_(int bms_index, BlockId block, const uint8_t *data) {
+  uint32_t now = millis();
+  uint32_t &last = uplink_last_sample_[bms_index][block];
+  if (last != 0 && now - last < uplink_sample_interval_) {
     return;
   }
+  last = std::max<uint32_t>(now, 1);
+  uplink_.add(now, bms_index, block, data + RESPONSE_HEADER_SIZE, data[2]);
+}
 
-  if (buffer[2] == 0x24) {  // 36-Byte-Paket
-    //ESP_LOGI("DEBUG", "buffer[3]: 0x%02X, buffer[4]: 0x%02X", buffer[3], buffer[4]);
-    std::vector<std::pair<sensor::Sensor*, float>> updates;
-
-    updates.emplace_back(pack_voltage_[bms_index], (buffer[3] << 8 | buffer[4]) / 100.0f);
-    updates.emplace_back(current_[bms_index], (int16_t(buffer[5] << 8 | buffer[6])) / 100.0f);
-    updates.emplace_back(remaining_capacity_[bms_index], (buffer[7] << 8 | buffer[8]) / 100.0f);
-    updates.emplace_back(total_capacity_[bms_index], (buffer[9] << 8 | buffer[10]) / 100.0f);
-    updates.emplace_back(total_discharge_capacity_[bms_index], (buffer[11] << 8 | buffer[12]) / 0.1f);
-    updates.emplace_back(soc_[bms_index], (buffer[13] << 8 | buffer[14]) / 10.0f);
-    updates.emplace_back(soh_[bms_index], (buffer[15] << 8 | buffer[16]) / 10.0f);
-    updates.emplace_back(cycle_count_[bms_index], (buffer[17] << 8 | buffer[18]));
-    updates.emplace_back(average_cell_voltage_[bms_index], (buffer[19] << 8 | buffer[20]) / 1000.0f);
-    updates.emplace_back(average_cell_temp_[bms_index], (buffer[21] << 8 | buffer[22]) / 10.0f - 273.15f);
-    updates.emplace_back(max_cell_voltage_[bms_index], (buffer[23] << 8 | buffer[24]) / 1000.0f);
-    updates.emplace_back(min_cell_voltage_[bms_index], (buffer[25] << 8 | buffer[26]) / 1000.0f);
-    updates.emplace_back(max_cell_temp_[bms_index], (buffer[27] << 8 | buffer[28]) / 10.0f - 273.15f);
-    updates.emplace_back(min_cell_temp_[bms_index], (buffer[29] << 8 | buffer[30]) / 10.0f - 273.15f);
-    updates.emplace_back(maxdiscurt_[bms_index], (buffer[33] << 8 | buffer[34]) / 1.0f);
-    updates.emplace_back(maxchgcurt_[bms_index], (buffer[35] << 8 | buffer[36]) / 1.0f);
-
-    for (auto &pair : updates) {
-      auto *sensor = pair.first;
-      auto value = pair.second;
-      if (sensor != nullptr) {
-        sensor->publish_state(value);
-      }
+void SeplosParser::flush_uplink_() {
+  if (!network::is_connected()) {
+    spill_uplink_();
+    return;
+  }
+  if (!uplink_.empty()) {
+    uint8_t mac[6];
+    get_mac_address_raw(mac);
+    std::string body;
+    size_t chunks = uplink_.write_payload(&body, UPLINK_POST_SIZE, bms_count_, mac, millis(), unix_time_());
+    if (!post_uplink_(body)) {
+      spill_uplink_();
+      return;
+    }
+    ESP_LOGD(TAG, "Upload: %u Byte, %u verworfene Abschnitte", (unsigned) body.size(), uplink_.dropped_chunks());
+    uplink_.consume(chunks);
+    if (!uplink_.empty()) {
+      // Rest wie beim Journal in eigenen POSTs, ohne loop() bis dahin zu blockieren
+      set_timeout("uplink_rest", 1000, [this]() { this->flush_uplink_(); });
+      return;
     }
   }
+  // Verbindung steht wieder: liegen gebliebene Abschnitte nachsenden
+  if (journal_ready_ && !journal_.empty()) {
+    drain_journal_();
+  }
+  // Eingefrorene Ereignisaufzeichnungen abliefern und neu scharfschalten
+  for (size_t i = 0; i < captures_.size(); i++) {
+    if (get_capture_state(i) != CAPTURE_FROZEN) {
+      continue;
+    }
+    std::string body;
+    CaptureInfo capture;
+    write_capture_payload(i, &body, &capture);
+    std::string info = str_sprintf("bms=%u;trigger_ms=%u;bits=", (unsigned) i, capture.trigger_time) +
+                       format_hex(capture.trigger_bits, ALARM_BYTES);
+    if (post_uplink_(body, info)) {
+      rearm_capture(i);
+    }
+  }
+}
+
+bool SeplosParser::post_uplink_(const std::string &body, const std::string &capture) {
+  std::list<http_request::Header> headers = {{"Content-Type", "application/octet-stream"},
+                                             {"X-Api-Key", uplink_api_key_.c_str()}};
+  if (!capture.empty()) {
+    headers.push_back({"X-Seplos-Capture", capture.c_str()});
+  }
+  auto container = uplink_http_->post(uplink_url_, body, headers);
+  int status = 0;
+  if (container != nullptr) {
+    status = container->status_code;
+    container->end();
+  }
+  if (status < 200 || status >= 300) {
+    uplink_failures_++;
+    ESP_LOGW(TAG, "Upload von %u Byte fehlgeschlagen (HTTP %d)", (unsigned) body.size(), status);
+    return false;
+  }
+  return true;
+}
 
-  if (buffer[2] == 0x34) {
-    std::vector<std::pair<sensor::Sensor*, float>> updates;
-
-    updates.emplace_back(cell_1_[bms_index], (buffer[3] << 8 | buffer[4]) / 1000.0f);
-    updates.emplace_back(cell_2_[bms_index], (buffer[5] << 8 | buffer[6]) / 1000.0f);
-    updates.emplace_back(cell_3_[bms_index], (buffer[7] << 8 | buffer[8]) / 1000.0f);
-    updates.emplace_back(cell_4_[bms_index], (buffer[9] << 8 | buffer[10]) / 1000.0f);
-    updates.emplace_back(cell_5_[bms_index], (buffer[11] << 8 | buffer[12]) / 1000.0f);
-    updates.emplace_back(cell_6_[bms_index], (buffer[13] << 8 | buffer[14]) / 1000.0f);
-    updates.emplace_back(cell_7_[bms_index], (buffer[15] << 8 | buffer[16]) / 1000.0f);
-    updates.emplace_back(cell_8_[bms_index], (buffer[17] << 8 | buffer[18]) / 1000.0);
-    updates.emplace_back(cell_9_[bms_index], (buffer[19] << 8 | buffer[20]) / 1000.0f);
-    updates.emplace_back(cell_10_[bms_index], (buffer[21] << 8 | buffer[22]) / 1000.0f);
-    updates.emplace_back(cell_11_[bms_index], (buffer[23] << 8 | buffer[24]) / 1000.0f);
-    updates.emplace_back(cell_12_[bms_index], (buffer[25] << 8 | buffer[26]) / 1000.0f);
-    updates.emplace_back(cell_13_[bms_index], (buffer[27] << 8 | buffer[28]) / 1000.0f);
-    updates.emplace_back(cell_14_[bms_index], (buffer[29] << 8 | buffer[30]) / 1000.0f);
-    updates.emplace_back(cell_15_[bms_index], (buffer[31] << 8 | buffer[32]) / 1000.0f);
-    updates.emplace_back(cell_16_[bms_index], (buffer[33] << 8 | buffer[34]) / 1000.0f);
-    updates.emplace_back(cell_temp_1_[bms_index], (buffer[35] << 8 | buffer[36]) / 10.0f - 273.15f);
-    updates.emplace_back(cell_temp_2_[bms_index], (buffer[37] << 8 | buffer[38]) / 10.0f - 273.15f);
-    updates.emplace_back(cell_temp_3_[bms_index], (buffer[39] << 8 | buffer[40]) / 10.0f - 273.15f);
-    updates.emplace_back(cell_temp_4_[bms_index], (buffer[41] << 8 | buffer[42]) / 10.0f - 273.15f);
-    updates.emplace_back(case_temp_[bms_index], (buffer[51] << 8 | buffer[52]) / 10.0f - 273.15f);
-    updates.emplace_back(power_temp_[bms_index], (buffer[53] << 8 | buffer[54]) / 10.0f - 273.15f);
-
-    for (auto &pair : updates) {
-      auto *sensor = pair.first;
-      auto value = pair.second;
-      if (sensor != nullptr) {
-        sensor->publish_state(value);
+void SeplosParser::spill_uplink_() {
+  if (!journal_ready_ || uplink_.empty()) {
+    return;  // Puffer läuft weiter; bei vollem Puffer werden die ältesten Abschnitte verworfen
+  }
+  // Der Zeitbezug gilt für alle Abschnitte dieses Durchgangs, auch über einen Neustart hinweg
+  JournalAnchor anchor{millis(), unix_time_()};
+  std::string chunk;
+  for (size_t i = 0; i < uplink_.chunk_count(); i++) {
+    chunk.clear();
+    uplink_.write_chunk(i, &chunk);
+    journal_.append(anchor, reinterpret_cast<const uint8_t *>(chunk.data()), chunk.size());
+  }
+  ESP_LOGD(TAG, "%u Abschnitte ins Journal geschrieben, %u warten", (unsigned) uplink_.chunk_count(),
+           journal_.pending_records());
+  uplink_.clear();
+}
+
+void SeplosParser::drain_journal_() {
+  JournalBatch batch;
+  if (!network::is_connected() || !journal_.read_batch(UPLINK_POST_SIZE, &batch)) {
+    return;
+  }
+  uint8_t mac[6];
+  get_mac_address_raw(mac);
+  std::string body;
+  body.reserve(UPLINK_HEADER_SIZE + batch.data.size());
+  write_uplink_header(&body, bms_count_, mac, batch.anchor.millis, batch.anchor.unix_time, batch.records, 0);
+  body += batch.data;
+  if (!post_uplink_(body)) {
+    return;  // beim nächsten flush_interval erneut
+  }
+  journal_.consume(batch);
+  ESP_LOGD(TAG, "Journal: %u Abschnitte nachgesendet, %u warten", batch.records, journal_.pending_records());
+  if (!journal_.empty()) {
+    set_timeout("journal", 1000, [this]() { this->drain_journal_(); });
+  }
+}
+#endif
+
+CaptureState SeplosParser::get_capture_state(int bms_index) const {
+  if (bms_index < 0 || size_t(bms_index) >= captures_.size()) {
+    return CAPTURE_ARMED;
+  }
+  LockGuard guard{capture_lock_};
+  return captures_[bms_index].state();
+}
+
+void SeplosParser::rearm_capture(int bms_index) {
+  if (bms_index >= 0 && size_t(bms_index) < captures_.size()) {
+    LockGuard guard{capture_lock_};
+    captures_[bms_index].rearm();
+  }
+}
+
+bool SeplosParser::write_capture_payload(int bms_index, std::string *out, CaptureInfo *info) {
+  if (bms_index < 0 || size_t(bms_index) >= captures_.size()) {
+    return false;
+  }
+  // Nur für die Dauer der Ausgabe belegt; ungünstigster Eintrag < 96 Byte, dazu Verschnitt am Abschnittsende.
+  // Die Sperre gilt nur für das Kopieren, das Kodieren läuft danach auf der Kopie.
+  UplinkRing ring;
+  {
+    LockGuard guard{capture_lock_};
+    const CaptureRing &capture = captures_[bms_index];
+    ring.configure(capture.size() * 96 + 2 * UplinkRing::CHUNK_SIZE, bms_index + 1);
+    for (size_t i = 0; i < capture.size(); i++) {
+      const CaptureEntry &entry = capture.entry(i);
+      ring.add(entry.time, bms_index, entry.block, entry.data, entry.length);
+    }
+    if (info != nullptr) {
+      info->state = capture.state();
+      info->frames = capture.size();
+      info->trigger_time = capture.trigger_time();
+      memcpy(info->trigger_bits, capture.trigger_bits(), ALARM_BYTES);
+    }
+  }
+  uint8_t mac[6];
+  get_mac_address_raw(mac);
+  ring.write_payload(out, SIZE_MAX, bms_count_, mac, millis(), unix_time_());
+  return true;
+}
+
+void SeplosParser::tick_history_() {
+  // Auch Packs ohne neue Frames schließen ihre letzte Minute ab
+  uint32_t now = millis();
+  LockGuard guard{history_lock_};
+  for (auto &history : histories_) {
+    history.tick(now);
+  }
+}
+
+#ifdef USE_SEPLOS_HISTORY
+bool SeplosParser::HistoryHandler::canHandle(AsyncWebServerRequest *request) {
+  return request->url() == "/seplos/history";
+}
+
+void SeplosParser::HistoryHandler::handleRequest(AsyncWebServerRequest *request) {
+  int bms_index = request->hasParam("bms") ? atoi(request->getParam("bms")->value().c_str()) : 0;
+  if (bms_index < 0 || size_t(bms_index) >= parent_->histories_.size()) {
+    request->send(404, "text/plain", "Kein Verlauf für dieses BMS");
+    return;
+  }
+  uint32_t from = request->hasParam("from") ? strtoul(request->getParam("from")->value().c_str(), nullptr, 10) : 0;
+  uint32_t to =
+      request->hasParam("to") ? strtoul(request->getParam("to")->value().c_str(), nullptr, 10) : UINT32_MAX;
+  // fields=current,soc wählt Spalten aus, ohne Angabe alle
+  const std::vector<SensorField> &fields = parent_->history_fields_;
+  std::vector<uint8_t> columns;
+  std::string selection = request->hasParam("fields") ? request->getParam("fields")->value().c_str() : "";
+  for (size_t i = 0; i < fields.size(); i++) {
+    std::string name = SENSOR_FIELD_NAMES[fields[i]];
+    if (selection.empty() || ("," + selection + ",").find("," + name + ",") != std::string::npos) {
+      columns.push_back(i);
+    }
+  }
+  uint32_t now = millis();
+  uint32_t unix_time = parent_->unix_time_();
+  std::shared_ptr<HistoryCursor> cursor;
+  {
+    // Der Cursor liest beim Anlegen Kopf, Füllstand und Zeitstempel des Rings, den loop() gleichzeitig beschreibt
+    LockGuard guard{parent_->history_lock_};
+    cursor = std::make_shared<HistoryCursor>(&parent_->histories_[bms_index], bms_index, std::move(columns), now,
+                                             unix_time, from, to);
+  }
+  SeplosParser *parent = parent_;
+#ifdef USE_ARDUINO
+  // ESPAsyncWebServer holt die Antwort stückweise über den Callback
+  request->send(request->beginChunkedResponse("application/json",
+                                              [parent, cursor](uint8_t *buffer, size_t max_length, size_t) {
+                                                LockGuard guard{parent->history_lock_};
+                                                return cursor->read(reinterpret_cast<char *>(buffer), max_length);
+                                              }));
+#else
+  // ESP-IDF: direkt im httpd-Task in Stücken senden, gesperrt nur während des Formatierens
+  httpd_req_t *req = *request;
+  httpd_resp_set_type(req, "application/json");
+  char buffer[512];
+  size_t length;
+  do {
+    {
+      LockGuard guard{parent->history_lock_};
+      length = cursor->read(buffer, sizeof(buffer));
+    }
+    if (httpd_resp_send_chunk(req, buffer, length) != ESP_OK) {
+      break;
+    }
+  } while (length > 0);
+#endif
+}
+#endif
+
+#ifdef USE_SEPLOS_CAPTURE_WEB
+bool SeplosParser::CaptureHandler::canHandle(AsyncWebServerRequest *request) {
+  return request->url() == "/seplos/capture";
+}
+
+void SeplosParser::CaptureHandler::handleRequest(AsyncWebServerRequest *request) {
+  int bms_index = request->hasParam("bms") ? atoi(request->getParam("bms")->value().c_str()) : 0;
+  if (bms_index < 0 || size_t(bms_index) >= parent_->captures_.size()) {
+    request->send(404, "text/plain", "Keine Aufzeichnung für dieses BMS");
+    return;
+  }
+  if (request->method() == HTTP_POST) {
+    parent_->rearm_capture(bms_index);
+    request->send(200, "text/plain", "OK");
+    return;
+  }
+  static const char *const STATES[] = {"armed", "triggered", "frozen"};
+  CaptureInfo capture;
+  std::string payload;
+  parent_->write_capture_payload(bms_index, &payload, &capture);
+  // Nutzdaten wie beim Upload, Base64-kodiert; tools/seplos_uplink.py dekodiert auch diese Antwort
+  AsyncResponseStream *stream = request->beginResponseStream("application/json");
+  stream->printf("{\"bms\":%d,\"state\":\"%s\",\"frames\":%u,\"trigger_ms\":%u,\"trigger_bits\":\"", bms_index,
+                 STATES[capture.state], (unsigned) capture.frames, capture.trigger_time);
+  stream->print(format_hex(capture.trigger_bits, ALARM_BYTES).c_str());
+  stream->print("\",\"payload\":\"");
+  stream->print(base64_encode(reinterpret_cast<const uint8_t *>(payload.data()), payload.size()).c_str());
+  stream->print("\"}");
+  request->send(stream);
+}
+#endif
+
+void SeplosParser::publish_bank_() {
+  uint32_t now = millis();
+  for (int field = 0; field < BANK_FIELD_COUNT; field++) {
+    sensor::Sensor *sensor = bank_sensors_[field];
+    if (sensor == nullptr) {
+      continue;
+    }
+    float value = bank_.get(static_cast<BankField>(field));
+    float &last_value = bank_last_value_[field];
+    if (std::isnan(value)) {
+      // Kein aktives Pack mehr: einmal als unbekannt melden
+      if (!std::isnan(last_value)) {
+        last_value = NAN;
+        sensor->publish_state(NAN);
       }
+      continue;
     }
+    uint32_t &last_time = bank_last_time_[field];
+    if (!publish_policies_[BANK_FIELD_CLASSES[field]].should_publish(last_value, now - last_time, value)) {
+      continue;
+    }
+    last_value = value;
+    last_time = now;
+    sensor->publish_state(value);
   }
-  if (buffer[2] == 0x12) {
-    //ESP_LOGW("seplos", "BMS-ID 0x12: %d", buffer[0]);
-    std::vector<std::string> active_alarms;
-    std::vector<std::string> active_protections;
-    std::vector<int> low_voltage_cells, high_voltage_cells;
-    std::vector<int> low_temp_cells, high_temp_cells;
-    std::vector<int> balancing_cells;
-    std::vector<std::string> system_status;
-    std::vector<std::string> fet_status;
-
-    auto parse_bits = [](uint8_t byte, int offset) {
-      std::vector<int> result;
-      for (int i = 0; i < 8; i++) {
-        if (byte & (1 << i)) {
-          result.push_back(i + offset);
+}
+
+void SeplosParser::process_alarm_frame_(const uint8_t *bits, int bms_index) {
+  uint8_t *previous = alarm_bits_[bms_index];
+  bool first = !alarm_received_[bms_index];
+  if (first || memcmp(previous, bits, ALARM_BYTES) != 0) {
+#ifdef USE_BINARY_SENSOR
+    // Binärsensoren folgen jeder Flanke sofort, unabhängig von update_interval
+    for (auto &binding : alarm_bindings_[bms_index]) {
+      const AlarmDescriptor &desc = ALARM_DESCRIPTORS[binding.alarm];
+      uint8_t index = desc.byte - ALARM_FIRST_BYTE;
+      if (first || ((bits[index] ^ previous[index]) & desc.mask)) {
+        binding.sensor->publish_state((bits[index] & desc.mask) != 0);
+      }
+    }
+#endif
+    if (!first && !captures_.empty()) {
+      LockGuard guard{capture_lock_};
+      for (int i = 0; i < ALARM_BYTES && captures_[bms_index].state() == CAPTURE_ARMED; i++) {
+        if (bits[i] & ~previous[i] & capture_mask_[i]) {
+          ESP_LOGW(TAG, "BMS %d: Alarmflanke in Byte %d, Aufzeichnung ausgelöst", bms_index, i + ALARM_FIRST_BYTE);
+          captures_[bms_index].trigger(millis(), bits);
+          break;
         }
       }
-      return result;
-    };
-
-    low_voltage_cells = parse_bits(buffer[3], 1);
-    auto low_v2 = parse_bits(buffer[4], 9);
-    low_voltage_cells.insert(low_voltage_cells.end(), low_v2.begin(), low_v2.end());
-
-    high_voltage_cells = parse_bits(buffer[5], 1);
-    auto high_v2 = parse_bits(buffer[6], 9);
-    high_voltage_cells.insert(high_voltage_cells.end(), high_v2.begin(), high_v2.end());
-
-    low_temp_cells = parse_bits(buffer[7], 1);
-    high_temp_cells = parse_bits(buffer[8], 1);
-
-    balancing_cells = parse_bits(buffer[9], 1);
-    auto bal2 = parse_bits(buffer[10], 9);
-    balancing_cells.insert(balancing_cells.end(), bal2.begin(), bal2.end());
-
-    if (buffer[11] & 0x01) system_status.push_back("Discharge");
-    if (buffer[11] & 0x02) system_status.push_back("Charge");
-    if (buffer[11] & 0x04) system_status.push_back("Floating Charge");
-    if (buffer[11] & 0x08) system_status.push_back("Full Charge");
-    if (buffer[11] & 0x10) system_status.push_back("Standby Mode");
-    if (buffer[11] & 0x20) system_status.push_back("Turn Off");
-
-    if (buffer[12] & 0x01) active_alarms.push_back("Cell High Voltage Alarm");
-    if (buffer[12] & 0x02) active_protections.push_back("Cell Over Voltage Protection");
-    if (buffer[12] & 0x04) active_alarms.push_back("Cell Low Voltage Alarm");
-    if (buffer[12] & 0x08) active_protections.push_back("Cell Under Voltage Protection");
-    if (buffer[12] & 0x10) active_alarms.push_back("Pack High Voltage Alarm");
-    if (buffer[12] & 0x20) active_protections.push_back("Pack Over Voltage Protection");
-    if (buffer[12] & 0x40) active_alarms.push_back("Pack Low Voltage Alarm");
-    if (buffer[12] & 0x80) active_protections.push_back("Pack Under Voltage Protection");
-
-    if (buffer[13] & 0x01) active_alarms.push_back("Charge High Temperature Alarm");
-    if (buffer[13] & 0x02) active_protections.push_back("Charge High Temperature Protection");
-    if (buffer[13] & 0x04) active_alarms.push_back("Charge Low Temperature Alarm");
-    if (buffer[13] & 0x08) active_protections.push_back("Charge Under Temperature Protection");
-    if (buffer[13] & 0x10) active_alarms.push_back("Discharge High Temperature Alarm");
-    if (buffer[13] & 0x20) active_protections.push_back("Discharge Over Temperature Protection");
-    if (buffer[13] & 0x40) active_alarms.push_back("Discharge Low Temperature Alarm");
-    if (buffer[13] & 0x80) active_protections.push_back("Discharge Under Temperature Protection");
-
-    if (buffer[14] & 0x01) active_alarms.push_back("High Environment Temperature Alarm");
-    if (buffer[14] & 0x02) active_protections.push_back("Over Environment Temperature Protection");
-    if (buffer[14] & 0x04) active_alarms.push_back("Low Environment Temperature Alarm");
-    if (buffer[14] & 0x08) active_protections.push_back("Under Environment Temperature Protection");
-    if (buffer[14] & 0x10) active_alarms.push_back("High Power Temperature Alarm");
-    if (buffer[14] & 0x20) active_protections.push_back("Over Power Temperature Protection");
-    if (buffer[14] & 0x40) active_alarms.push_back("Cell Temperature Low Heating");
-
-    if (buffer[15] & 0x01) active_alarms.push_back("Charge Current Alarm");
-    if (buffer[15] & 0x02) active_protections.push_back("Charge Over Current Protection");
-    if (buffer[15] & 0x04) active_protections.push_back("Charge Second Level Current Protection");
-    if (buffer[15] & 0x08) active_alarms.push_back("Discharge Current Alarm");
-    if (buffer[15] & 0x10) active_protections.push_back("Discharge Over Current Protection");
-    if (buffer[15] & 0x20) active_protections.push_back("Discharge Second Level Over Current Protection");
-    if (buffer[15] & 0x40) active_protections.push_back("Output Short Circuit Protection");
-
-    if (buffer[16] & 0x01) active_alarms.push_back("Output Short Latch Up");
-    if (buffer[16] & 0x04) active_alarms.push_back("Second Charge Latch Up");
-    if (buffer[16] & 0x08) active_alarms.push_back("Second Discharge Latch Up");
-
-    if (buffer[17] & 0x04) active_alarms.push_back("SOC Alarm");
-    if (buffer[17] & 0x08) active_protections.push_back("SOC Protection");
-    if (buffer[17] & 0x10) active_alarms.push_back("Cell Difference Alarm");
-
-    if (buffer[18] & 0x01) fet_status.push_back("Discharge FET On");
-    if (buffer[18] & 0x02) fet_status.push_back("Charge FET On");
-    if (buffer[18] & 0x04) fet_status.push_back("Current Limiting FET On");
-    if (buffer[18] & 0x08) fet_status.push_back("Heating On");
-
-    if (buffer[19] & 0x01) active_alarms.push_back("Low SOC Alarm");
-    if (buffer[19] & 0x02) active_alarms.push_back("Intermittent Charge");
-    if (buffer[19] & 0x04) active_alarms.push_back("External Switch Conrol");
-    if (buffer[19] & 0x08) active_alarms.push_back("Static Standy Sleep Mode");
-    if (buffer[19] & 0x10) active_alarms.push_back("History Data Recording");
-    if (buffer[19] & 0x20) active_protections.push_back("Under SOC Protections");
-    if (buffer[19] & 0x40) active_alarms.push_back("Active Limited Current");
-    if (buffer[19] & 0x80) active_alarms.push_back("Passive Limited Current");
-
-    if (buffer[20] & 0x01) active_protections.push_back("NTC Fault");
-    if (buffer[20] & 0x02) active_protections.push_back("AFE Fault");
-    if (buffer[20] & 0x04) active_protections.push_back("Charge Mosfet Fault");
-    if (buffer[20] & 0x08) active_protections.push_back("Discharge Mosfet Fault");
-    if (buffer[20] & 0x10) active_protections.push_back("Cell Fault");
-    if (buffer[20] & 0x20) active_protections.push_back("Break Line Fault");
-    if (buffer[20] & 0x40) active_protections.push_back("Key Fault");
-    if (buffer[20] & 0x80) active_protections.push_back("Aerosol Alarm");
-
-    std::string volt_str = join_list(low_voltage_cells, ", ");
-    if (!volt_str.empty() && !high_voltage_cells.empty()) volt_str += " | " + join_list(high_voltage_cells, ", ");
-    else volt_str += join_list(high_voltage_cells, ", ");
-
-    std::string temp_str = join_list(low_temp_cells, ", ");
-    if (!temp_str.empty() && !high_temp_cells.empty()) temp_str += " | " + join_list(high_temp_cells, ", ");
-    else temp_str += join_list(high_temp_cells, ", ");
-
-    if (should_update(bms_index)) {
-      if (cell_voltage_alarms_[bms_index]) cell_voltage_alarms_[bms_index]->publish_state(volt_str);
-      if (cell_temperature_alarms_[bms_index]) cell_temperature_alarms_[bms_index]->publish_state(temp_str);
-      if (active_balancing_cells_[bms_index]) active_balancing_cells_[bms_index]->publish_state(join_list(balancing_cells, ", "));
-      if (system_status_[bms_index]) system_status_[bms_index]->publish_state(join_list(system_status, ", "));
-      if (FET_status_[bms_index]) FET_status_[bms_index]->publish_state(join_list(fet_status, ", "));
-      if (active_alarms_[bms_index]) active_alarms_[bms_index]->publish_state(join_list(active_alarms, ", "));
-      if (active_protections_[bms_index]) active_protections_[bms_index]->publish_state(join_list(active_protections, ", "));
-    }
-  }
-}
-
-const uint16_t crc_table[256] = {
-  0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
-  0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
-  0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
-  0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
-  0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
-  0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
-  0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
-  0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
-  0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
-  0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
-  0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
-  0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
-  0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
-  0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
-  0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
-  0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
-  0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
-  0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
-  0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
-  0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
-  0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
-  0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
-  0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
-  0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
-  0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
-  0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
-  0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
-  0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
-  0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
-  0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
-  0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
-  0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
-};
-
-uint16_t SeplosParser::calculate_modbus_crc(const std::deque<uint8_t> &data, size_t length) {
-  uint16_t crc = 0xFFFF;
-  for (size_t i = 0; i < length; i++) {
-    uint8_t index = crc ^ data[i];
-    crc = (crc >> 8) ^ crc_table[index];
-  }
-  return crc;
+    }
+    // Bytes 9/10: Zellen 1-8 und 9-16 im Balancing
+    pack_statistics_[bms_index].cells.set_balancing(bits[9 - ALARM_FIRST_BYTE] |
+                                                    bits[10 - ALARM_FIRST_BYTE] << 8);
+    if (master_) {
+      update_master_alarm_(bms_index, bits);
+    }
+    memcpy(previous, bits, ALARM_BYTES);
+    alarm_received_[bms_index] = true;
+  }
+
+  if (!should_update(bms_index)) {
+    return;
+  }
+  // Texte nur neu aufbauen, wenn sich ihre Bytes seit der letzten Veröffentlichung geändert haben
+  uint8_t *published = alarm_published_bits_[bms_index];
+  bool all = !alarm_text_published_[bms_index];
+  text_sensor::TextSensor **text = field_text_sensors_[bms_index];
+  for (int field = 0; field < TEXT_FIELD_COUNT; field++) {
+    if (text[field] == nullptr) {
+      continue;
+    }
+    uint8_t from, to;
+    alarm_text_bytes_(static_cast<TextField>(field), &from, &to);
+    if (!all && memcmp(published + from, bits + from, to - from) == 0) {
+      continue;
+    }
+    render_alarm_text_(static_cast<TextField>(field), bits);
+    text[field]->publish_state(text_buffer_);
+  }
+  memcpy(published, bits, ALARM_BYTES);
+  alarm_text_published_[bms_index] = true;
+}
+
+// Ein Text je Pack und Block statt eines Sensors je Wert:
+//   0x24/0x34: alle Felder des Blocks in Registerreihenfolge, durch Komma getrennt, in Registerauflösung
+//              (0x34: 16 Zellspannungen, 4 Zelltemperaturen, Gehäuse, Leistungsteil); nie empfangene Felder leer
+//   0x12:      die 18 Alarm-Bytes (Frame-Bytes 3-20) als Hex, Bitbelegung wie in SEPLOS_ALARM_BITS
+// Höchstens einmal je update_interval, Alarme bei jeder Änderung sofort; unveränderter Inhalt wird nicht erneut
+// veröffentlicht.
+void SeplosParser::publish_packed_(int bms_index, BlockId block) {
+  text_sensor::TextSensor *sensor = packed_sensors_[bms_index][block];
+  if (sensor == nullptr) {
+    return;
+  }
+  uint32_t now = millis();
+  uint32_t &last_time = packed_last_time_[bms_index][block];
+  if (block == BLOCK_PIC) {
+    text_buffer_ = format_hex(alarm_bits_[bms_index], ALARM_BYTES);
+  } else {
+    if (last_time != 0 && now - last_time < update_interval_) {
+      return;
+    }
+    text_buffer_.clear();
+    const BlockDescriptor &desc = BLOCKS[block];
+    for (int i = 0; i < desc.field_count; i++) {
+      if (i > 0) {
+        text_buffer_ += ',';
+      }
+      float value = field_values_[bms_index][desc.fields[i].field];
+      if (std::isnan(value)) {
+        continue;
+      }
+      float divisor = desc.fields[i].divisor;
+      int decimals = divisor >= 1000.0f ? 3 : divisor >= 100.0f ? 2 : divisor >= 10.0f ? 1 : 0;
+      char number[16];
+      snprintf(number, sizeof(number), "%.*f", decimals, value);
+      text_buffer_ += number;
+    }
+  }
+  if (last_time != 0 && sensor->state == text_buffer_) {
+    return;
+  }
+  last_time = std::max<uint32_t>(now, 1);
+  sensor->publish_state(text_buffer_);
+}
+
+// Bereich [from, to) der Alarm-Bytes, aus dem ein Textfeld entsteht
+void SeplosParser::alarm_text_bytes_(TextField field, uint8_t *from, uint8_t *to) {
+  switch (field) {
+    case TEXT_CELL_VOLTAGE_ALARMS: *from = 3; *to = 7; break;
+    case TEXT_CELL_TEMPERATURE_ALARMS: *from = 7; *to = 9; break;
+    case TEXT_ACTIVE_BALANCING_CELLS: *from = 9; *to = 11; break;
+    case TEXT_SYSTEM_STATUS: *from = 11; *to = 12; break;
+    case TEXT_FET_STATUS: *from = 18; *to = 19; break;
+    default: *from = 12; *to = 21; break;  // Alarme und Schutzfunktionen
+  }
+  *from -= ALARM_FIRST_BYTE;
+  *to -= ALARM_FIRST_BYTE;
+}
+
+// Hängt die Nummern der gesetzten Bits an ("1, 5, 12"), Bit 0 des ersten Bytes ist Zelle 1
+static void append_cells(std::string &out, const uint8_t *bytes, int count, bool &any) {
+  for (int byte = 0; byte < count; byte++) {
+    for (int bit = 0; bit < 8; bit++) {
+      if (bytes[byte] & (1 << bit)) {
+        if (any) out += ", ";
+        char number[4];
+        snprintf(number, sizeof(number), "%d", byte * 8 + bit + 1);
+        out += number;
+        any = true;
+      }
+    }
+  }
+}
+
+// Niedrig- und Hoch-Liste, getrennt durch " | " wenn beide belegt sind
+static void append_cell_pair(std::string &out, const uint8_t *low, const uint8_t *high, int count) {
+  bool any_low = false, any_high = false;
+  append_cells(out, low, count, any_low);
+  size_t split = out.size();
+  append_cells(out, high, count, any_high);
+  if (any_low && any_high) {
+    out.insert(split, " | ");
+  }
+}
+
+void SeplosParser::render_alarm_text_(TextField field, const uint8_t *bits) {
+  text_buffer_.clear();
+  const uint8_t *frame = bits - ALARM_FIRST_BYTE;  // Indizes wie im Frame
+  bool any = false;
+  AlarmKind kind;
+  switch (field) {
+    case TEXT_CELL_VOLTAGE_ALARMS:
+      append_cell_pair(text_buffer_, frame + 3, frame + 5, 2);
+      return;
+    case TEXT_CELL_TEMPERATURE_ALARMS:
+      append_cell_pair(text_buffer_, frame + 7, frame + 8, 1);
+      return;
+    case TEXT_ACTIVE_BALANCING_CELLS:
+      append_cells(text_buffer_, frame + 9, 2, any);
+      return;
+    case TEXT_SYSTEM_STATUS: kind = ALARM_KIND_STATUS; break;
+    case TEXT_FET_STATUS: kind = ALARM_KIND_FET; break;
+    case TEXT_ACTIVE_ALARMS: kind = ALARM_KIND_ALARM; break;
+    default: kind = ALARM_KIND_PROTECTION; break;
+  }
+  for (const AlarmDescriptor &desc : ALARM_DESCRIPTORS) {
+    if (desc.kind == kind && (frame[desc.byte] & desc.mask)) {
+      if (any) text_buffer_ += ", ";
+      text_buffer_ += desc.text;
+      any = true;
+    }
+  }
+}
+
+// first_register/register_count: vom Frame abgedeckter Ausschnitt des Blocks, relativ zum Blockanfang
+void SeplosParser::publish_fields_(const BlockDescriptor &block, const uint8_t *data, int bms_index,
+                                   uint16_t first_register, uint16_t register_count) {
+  sensor::Sensor **sensors = field_sensors_[bms_index];
+  uint32_t now = millis();
+  size_t skip = first_register * 2;
+  size_t end = skip + register_count * 2;
+  for (size_t i = 0; i < block.field_count; i++) {
+    const FieldDescriptor &desc = block.fields[i];
+    size_t offset = desc.offset - RESPONSE_HEADER_SIZE;  // Offset innerhalb der Datenbytes eines vollständigen Blocks
+    if (offset < skip || offset + desc.width > end) {
+      continue;
+    }
+    float value = decode_register(desc, data + RESPONSE_HEADER_SIZE + offset - skip);
+    field_values_[bms_index][desc.field] = value;
+    sensor::Sensor *sensor = sensors[desc.field];
+    if (sensor == nullptr) {
+      continue;
+    }
+    // Unveränderte Werte erreichen weder die API noch den web_server
+    float &last_value = last_published_value_[bms_index][desc.field];
+    uint32_t &last_time = last_published_time_[bms_index][desc.field];
+    if (!publish_policies_[desc.field_class].should_publish(last_value, now - last_time, value)) {
+      continue;
+    }
+    last_value = value;
+    last_time = now;
+    sensor->publish_state(value);
+  }
 }
 
 void SeplosParser::dump_config(){
+    FrameScannerStats stats = scanner_stats_();
+    ESP_LOGCONFIG(TAG, "Seplos Parser:");
+    if (gap_framing_) {
+      ESP_LOGCONFIG(TAG, "  Framing: Pause (t3.5 = %u µs)", buses_[0].frame_gap_us);
+      ESP_LOGCONFIG(TAG, "  Frames per Pause: %u, per Header-Suche zerlegte Abschnitte: %u, Pausen im Frame: %u",
+                    stats.gap_frames, stats.gap_fallbacks, stats.gap_splits);
+    } else {
+      ESP_LOGCONFIG(TAG, "  Framing: Header");
+    }
+    ESP_LOGCONFIG(TAG, "  Frames: %u, Fehlsynchronisationen: %u, verworfene Bytes: %u", stats.frames,
+                  stats.crc_errors, stats.resync_bytes);
+    ESP_LOGCONFIG(TAG, "  Zeitbudget je loop(): %u µs, verschobene Frames: %u", loop_budget_us_, frames_deferred_);
+    ESP_LOGCONFIG(TAG, "  UART-Puffer: %u Byte, voll bei %u loop()-Aufrufen",
+                  (unsigned) parent_->get_rx_buffer_size(), uart_overruns_);
+    if (buses_.size() > 1) {
+      for (size_t i = 0; i < buses_.size(); i++) {
+        const Bus &bus = buses_[i];
+        const FrameScannerStats &bus_stats = bus.scanner.get_stats();
+        ESP_LOGCONFIG(TAG, "  Bus %u: BMS %u-%u, %u Baud, t3.5 %u µs, Frames: %u, CRC-Fehler: %u", (unsigned) i,
+                      bus.first_pack, bus.first_pack + bus.pack_count - 1, bus.uart->get_baud_rate(),
+                      bus.frame_gap_us, bus_stats.frames, bus_stats.crc_errors);
+      }
+    }
+    ESP_LOGCONFIG(TAG, "  Bytes: %u, CRC-Fehler: %u, verdrängte Bytes: %u, ungültige BMS-IDs: %u",
+                  stats.bytes_received, stats.crc_errors, stats.evicted_bytes, invalid_bms_ids_);
+    ESP_LOGCONFIG(TAG, "  Frames 0x24/0x34/0x12: %u/%u/%u", frames_per_block_[BLOCK_PIA],
+                  frames_per_block_[BLOCK_PIB], frames_per_block_[BLOCK_PIC]);
+    ESP_LOGCONFIG(TAG, "  Veraltet nach: %u ms", stale_timeout_);
+    if (master_) {
+      const PollStats &poll = scheduler_.get_stats();
+      ESP_LOGCONFIG(TAG, "  Master: 0x24/0x34/0x12 alle %u/%u/%u ms, Busbudget %.0f %%%s",
+                    scheduler_.get_interval(BLOCK_PIA) / 1000, scheduler_.get_interval(BLOCK_PIB) / 1000,
+                    scheduler_.get_interval(BLOCK_PIC) / 1000, scheduler_.get_bus_budget() * 100.0f,
+                    flow_control_pin_ != nullptr ? ", DE/RE per Pin" : "");
+      ESP_LOGCONFIG(TAG, "  Anfragen: %u, Antworten: %u, Ausnahmen: %u, Zeitüberschreitungen: %u, ausgefallen: %u",
+                    poll.requests, poll.responses, poll.exceptions, poll.timeouts, poll.failures);
+    }
+    if (!captures_.empty()) {
+      ESP_LOGCONFIG(TAG, "  Ereignisaufzeichnung: %u Frames vor, %u nach dem Auslösen", capture_pre_trigger_,
+                    capture_post_trigger_);
+    }
+    if (!histories_.empty()) {
+      ESP_LOGCONFIG(TAG, "  Verlauf: %u Minuten, %u Felder, %u Byte je Pack", (unsigned) history_slots_,
+                    (unsigned) history_fields_.size(),
+                    (unsigned) HistoryRing::storage_size(history_fields_.size(), history_slots_));
+    }
+#ifdef USE_SEPLOS_UPLINK
+    if (uplink_http_ != nullptr) {
+      ESP_LOGCONFIG(TAG, "  Upload: %s alle %u s, Abtastung %u ms, Puffer %u Byte", uplink_url_.c_str(),
+                    uplink_flush_interval_ / 1000, uplink_sample_interval_, (unsigned) uplink_buffer_size_);
+      if (journal_ready_) {
+        const JournalStats &journal = journal_.get_stats();
+        ESP_LOGCONFIG(TAG, "  Journal: %u offen, %u geschrieben, %u verworfen, %u Sektoren gelöscht",
+                      journal_.pending_records(), journal.records_written, journal.records_dropped,
+                      journal.sector_erases);
+      }
+    }
+#endif
+    for (int i = 0; i < bms_count_ && i < MAX_BMS_COUNT; i++) {
+      ESP_LOGCONFIG(TAG, "  BMS %d: %u Frames, %s", i, frames_per_bms_[i], is_online(i) ? "online" : "offline");
+    }
+    ESP_LOGCONFIG(TAG, "  loop() µs:%s (max %u)", format_histogram(loop_time_).c_str(), loop_time_.max);
+    ESP_LOGCONFIG(TAG, "  Ankunft bis Veröffentlichung µs:%s (max %u)", format_histogram(publish_latency_).c_str(),
+                  publish_latency_.max);
+    sample_heap_();
+    ESP_LOGCONFIG(TAG, "  Heap frei: %u, minimal: %u", free_heap_, min_free_heap_);
     for (int i = 0; i < bms_count_; i++) {
      last_updates_[i] = millis();
      //ESP_LOGD("SeplosParser", "Initialisiere Timer für BMS %d: %u", i, last_updates_[i]);
@@ -419,19 +1169,60 @@ void SeplosParser::dump_config(){
         LOG_TEXT_SENSOR("  ", "Text sensor", text_sensor);
     }
 
-//    for(auto *binary_sensor : this->binary_sensors_){
-//        LOG_BINARY_SENSOR("  ", "Binary sensor", binary_sensor);
-//    }
+#ifdef USE_BINARY_SENSOR
+    for(auto *binary_sensor : this->binary_sensors_){
+        LOG_BINARY_SENSOR("  ", "Binary sensor", binary_sensor);
+    }
+#endif
 }
 void SeplosParser::set_bms_count(int bms_count) {
-  this->bms_count_ = bms_count;  // Wert speichern
-  last_updates_.resize(bms_count, 0);  // Dynamische Größe
+  if (buses_.empty()) {
+    buses_.emplace_back();
+  }
+  buses_[0].pack_count = bms_count;
+  // Weitere Busse rücken nach
+  int first_pack = 0;
+  for (Bus &bus : buses_) {
+    bus.first_pack = first_pack;
+    first_pack += bus.pack_count;
+  }
+  this->bms_count_ = first_pack;
+  last_updates_.resize(bms_count_, 0);  // Dynamische Größe
+  pack_statistics_.resize(bms_count_);
   ESP_LOGI("SeplosParser", "BMS Count gesetzt auf: %d", bms_count);
 }
+void SeplosParser::add_bus(uart::UARTComponent *uart, int bms_count) {
+  if (buses_.empty()) {
+    set_bms_count(1);
+  }
+  buses_.emplace_back();
+  Bus &bus = buses_.back();
+  bus.uart = uart;
+  bus.first_pack = bms_count_;
+  bus.pack_count = bms_count;
+  this->bms_count_ += bms_count;
+  last_updates_.resize(bms_count_, 0);
+  pack_statistics_.resize(bms_count_);
+}
+bool SeplosParser::valid_bms_index_(int bms_index) {
+  if (bms_index < 0 || bms_index >= MAX_BMS_COUNT) {
+    ESP_LOGE(TAG, "Sensor für BMS-Index %d ignoriert (höchstens %d Packs)", bms_index, MAX_BMS_COUNT);
+    return false;
+  }
+  return true;
+}
 void SeplosParser::set_update_interval(int update_interval) {
   this->update_interval_ = update_interval*1000;
   ESP_LOGI("SeplosParser", "update interval: %d", update_interval);
 }
+void SeplosParser::set_publish_policy(FieldClass field_class, uint32_t min_interval, float deadband,
+                                      float relative_deadband, uint32_t max_silence) {
+  PublishPolicy &policy = publish_policies_[field_class];
+  policy.min_interval = min_interval;
+  policy.deadband = deadband;
+  policy.relative_deadband = relative_deadband;
+  policy.max_silence = max_silence;
+}
 bool SeplosParser::should_update(int bms_index) {
   if (bms_index < 0 || bms_index >= bms_count_) {
     //ESP_LOGW("SeplosParser", "Ungültiger BMS-Index: %d (max: %d)", bms_index, bms_count_);
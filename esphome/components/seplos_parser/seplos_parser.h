@@ -2,19 +2,40 @@
 
 #include "esphome/core/component.h"
 #include "esphome/core/defines.h"
+#include "esphome/core/gpio.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/uart/uart.h"
+#include "seplos_bank.h"
+#include "seplos_capture.h"
+#include "seplos_diagnostics.h"
+#include "seplos_frame.h"
+#include "seplos_history.h"
+#include "seplos_journal.h"
+#include "seplos_master.h"
+#include "seplos_registers.h"
+#include "seplos_stats.h"
+#include "seplos_uplink.h"
 #include <vector>
-#include <deque>
 
 #ifdef USE_SENSOR
 #include "esphome/components/sensor/sensor.h"
 #endif
-//#ifdef USE_BINARY_SENSOR
-//#include "esphome/components/binary_sensor/binary_sensor.h"
-//#endif
+#ifdef USE_BINARY_SENSOR
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#endif
 #ifdef USE_TEXT_SENSOR
 #include "esphome/components/text_sensor/text_sensor.h"
 #endif
+#ifdef USE_TIME
+#include "esphome/components/time/real_time_clock.h"
+#endif
+#ifdef USE_SEPLOS_UPLINK
+#include "esphome/components/http_request/http_request.h"
+#endif
+#if defined(USE_SEPLOS_CAPTURE_WEB) || defined(USE_SEPLOS_HISTORY)
+#include "esphome/components/web_server_base/web_server_base.h"
+#endif
 
 namespace esphome {
 namespace seplos_parser {
@@ -25,88 +46,367 @@ class SeplosParser : public uart::UARTDevice, public Component {
   std::vector<sensor::Sensor *> sensors_;
 
  public:
-  void register_sensor(sensor::Sensor *obj) { this->sensors_.push_back(obj); }
-#endif
-//#ifdef USE_BINARY_SENSOR
-// protected:
-//  std::vector<binary_sensor::BinarySensor *> binary_sensors_;
-//
-// public:
-//  void register_binary_sensor(binary_sensor::BinarySensor *obj) { this->binary_sensors_.push_back(obj); }
-//#endif
+  void register_sensor(int bms_index, SensorField field, sensor::Sensor *obj) {
+    if (!valid_bms_index_(bms_index))
+      return;
+    this->sensors_.push_back(obj);
+    this->field_sensors_[bms_index][field] = obj;
+  }
+  void register_diagnostic_sensor(DiagnosticField field, sensor::Sensor *obj) {
+    this->sensors_.push_back(obj);
+    this->diagnostic_sensors_[field] = obj;
+  }
+  void register_pack_diagnostic_sensor(int bms_index, PackDiagnosticField field, sensor::Sensor *obj) {
+    if (!valid_bms_index_(bms_index))
+      return;
+    this->sensors_.push_back(obj);
+    this->pack_diagnostic_sensors_[bms_index][field] = obj;
+  }
+  void register_bank_sensor(BankField field, sensor::Sensor *obj) {
+    this->sensors_.push_back(obj);
+    this->bank_sensors_[field] = obj;
+  }
+  void register_statistic_sensor(int bms_index, StatQuantity quantity, StatWindow window,
+                                 StatAggregation aggregation, sensor::Sensor *obj) {
+    if (!valid_bms_index_(bms_index))
+      return;
+    this->sensors_.push_back(obj);
+    this->statistic_bindings_.push_back({uint8_t(bms_index), quantity, window, aggregation, obj});
+  }
+  void register_energy_sensor(int bms_index, EnergyField field, sensor::Sensor *obj) {
+    if (!valid_bms_index_(bms_index))
+      return;
+    this->sensors_.push_back(obj);
+    this->energy_bindings_.push_back({uint8_t(bms_index), field, obj});
+  }
+  // cell nur für die Werte je Zelle (0-basiert)
+  void register_cell_sensor(int bms_index, CellField field, int cell, sensor::Sensor *obj) {
+    if (!valid_bms_index_(bms_index))
+      return;
+    this->sensors_.push_back(obj);
+    this->cell_bindings_.push_back({uint8_t(bms_index), field, uint8_t(cell), obj});
+  }
+#endif
+#ifdef USE_BINARY_SENSOR
+ protected:
+  struct AlarmBinding {
+    AlarmBit alarm;
+    binary_sensor::BinarySensor *sensor;
+  };
+  std::vector<binary_sensor::BinarySensor *> binary_sensors_;
+  std::vector<AlarmBinding> alarm_bindings_[MAX_BMS_COUNT];
+  binary_sensor::BinarySensor *online_sensors_[MAX_BMS_COUNT]{};
+
+ public:
+  void register_binary_sensor(int bms_index, AlarmBit alarm, binary_sensor::BinarySensor *obj) {
+    if (!valid_bms_index_(bms_index))
+      return;
+    this->binary_sensors_.push_back(obj);
+    this->alarm_bindings_[bms_index].push_back({alarm, obj});
+  }
+  void register_online_sensor(int bms_index, binary_sensor::BinarySensor *obj) {
+    if (!valid_bms_index_(bms_index))
+      return;
+    this->binary_sensors_.push_back(obj);
+    this->online_sensors_[bms_index] = obj;
+  }
+#endif
 #ifdef USE_TEXT_SENSOR
  protected:
   std::vector<text_sensor::TextSensor *> text_sensors_;
 
  public:
-  void register_text_sensor(text_sensor::TextSensor *obj) { this->text_sensors_.push_back(obj); }
+  void register_text_sensor(int bms_index, TextField field, text_sensor::TextSensor *obj) {
+    if (!valid_bms_index_(bms_index))
+      return;
+    this->text_sensors_.push_back(obj);
+    this->field_text_sensors_[bms_index][field] = obj;
+  }
+  // Alle Werte eines Blocks in einem Textsensor (packed:), Format siehe publish_packed_()
+  void register_packed_sensor(int bms_index, BlockId block, text_sensor::TextSensor *obj) {
+    if (!valid_bms_index_(bms_index))
+      return;
+    this->text_sensors_.push_back(obj);
+    this->packed_sensors_[bms_index][block] = obj;
+  }
 #endif
 
+  // Packs am eigenen UART (Adressen 0x01..)
   void set_bms_count(int bms_count);
+  // Weiterer RS-485-Strang an einem eigenen UART; seine Packs folgen im BMS-Index auf die bisher angelegten
+  void add_bus(uart::UARTComponent *uart, int bms_count);
+  void set_gap_framing(bool gap_framing) { gap_framing_ = gap_framing; }
+  void set_frame_gap(uint32_t frame_gap_us) { frame_gap_us_ = frame_gap_us; }
+  void set_loop_budget(uint32_t loop_budget_us) { loop_budget_us_ = loop_budget_us; }
+  void set_stale_timeout(uint32_t stale_timeout) { stale_timeout_ = stale_timeout; }
+  void set_restore_energy(bool restore_energy) { restore_energy_ = restore_energy; }
+  void set_preference_key(const std::string &preference_key) { preference_key_ = preference_key; }
+#ifdef USE_TIME
+  void set_time(time::RealTimeClock *time) { time_ = time; }
+#endif
+#ifdef USE_SEPLOS_UPLINK
+  void set_uplink(http_request::HttpRequestComponent *http_request, const std::string &url) {
+    uplink_http_ = http_request;
+    uplink_url_ = url;
+  }
+  void set_uplink_api_key(const std::string &api_key) { uplink_api_key_ = api_key; }
+  void set_uplink_buffer_size(size_t buffer_size) { uplink_buffer_size_ = buffer_size; }
+  void set_uplink_sample_interval(uint32_t sample_interval) { uplink_sample_interval_ = sample_interval; }
+  void set_uplink_flush_interval(uint32_t flush_interval) { uplink_flush_interval_ = flush_interval; }
+#ifdef USE_ESP32
+  void set_journal_partition(const std::string &label) { journal_partition_ = label; }
+#endif
+#endif
+  void set_capture(uint16_t pre_trigger, uint16_t post_trigger) {
+    capture_pre_trigger_ = pre_trigger;
+    capture_post_trigger_ = post_trigger;
+  }
+  // Neu gesetzte Bits dieser Alarme lösen die Ereignisaufzeichnung aus
+  void add_capture_trigger(AlarmBit alarm) {
+    const AlarmDescriptor &desc = ALARM_DESCRIPTORS[alarm];
+    capture_mask_[desc.byte - ALARM_FIRST_BYTE] |= desc.mask;
+  }
+  CaptureState get_capture_state(int bms_index) const;
+  // Eingefrorene Aufzeichnung verwerfen und wieder scharfschalten
+  void rearm_capture(int bms_index);
+  // Aufzeichnung im Upload-Format (seplos_uplink.h); false ohne Aufzeichnung für dieses BMS. info erhält den
+  // Zustand zum selben Zeitpunkt wie die Frames.
+  bool write_capture_payload(int bms_index, std::string *out, CaptureInfo *info = nullptr);
+  // Minutenverlauf über slots Minuten; Felder in der Reihenfolge der Spalten
+  void set_history(size_t slots) { history_slots_ = slots; }
+  void add_history_field(SensorField field) { history_fields_.push_back(field); }
+  // Packs am eigenen UART (Bus 0) selbst abfragen statt mitzulesen; Zeiten in ms
+  void set_master(bool master) { master_ = master; }
+  void set_master_interval(int block, uint32_t interval) {
+    scheduler_.set_interval(static_cast<BlockId>(block), interval * 1000);
+  }
+  void set_master_alarm_interval(uint32_t interval) { scheduler_.set_alarm_interval(interval * 1000); }
+  void set_master_bus_budget(float fraction) { scheduler_.set_bus_budget(fraction); }
+  void set_master_timeout(uint32_t timeout) { scheduler_.set_timeout(timeout * 1000); }
+  void set_master_retries(uint8_t retries) { scheduler_.set_retries(retries); }
+  void set_flow_control_pin(GPIOPin *pin) { flow_control_pin_ = pin; }
+  void on_shutdown() override;
   void set_update_interval(int update_interval);
+  void set_publish_policy(FieldClass field_class, uint32_t min_interval, float deadband, float relative_deadband,
+                          uint32_t max_silence);
   void setup() override;
   void loop() override;
   void dump_config() override;
-  bool is_valid_header();
   bool should_update(int bms_index);
-  size_t get_expected_length();
-  bool validate_crc(size_t length);
-  void process_packet(size_t length);
-  uint16_t calculate_modbus_crc(const std::deque<uint8_t> &data, size_t length);
+  // Zeitpunkt (millis) der letzten gültigen Antwort eines Blocks, 0 = noch nie
+  uint32_t get_last_seen(int bms_index, BlockId block) const { return last_seen_[bms_index][block]; }
+  // Mindestens ein Block innerhalb von stale_timeout empfangen
+  bool is_online(int bms_index) const;
+  bool is_stale(int bms_index, BlockId block) const;
+  // bus_index 0 = eigener UART, danach in der Reihenfolge von add_bus()
+  void process_packet(const ModbusFrame &frame, int bus_index = 0);
 
 private:
-  int bms_count_;  // Variable zur Speicherung von bms_count
+  // Schützt die Arrays je Pack, falls ein bms_index an der Konfigurationsprüfung vorbeikommt
+  static bool valid_bms_index_(int bms_index);
+  int bms_count_{0};  // Summe über alle Busse
   uint32_t update_interval_;
   std::vector<uint32_t> last_updates_; // Timer für jedes BMS-Gerät
-  //std::vector<uint8_t> buffer;
-  std::deque<uint8_t> buffer;
+  bool gap_framing_{false};
+  uint32_t frame_gap_us_{0};  // 0 = je Bus aus der Baudrate berechnen
+  HighFrequencyLoopRequester high_freq_;
+  uint32_t loop_budget_us_{4000};
+  uint32_t stale_timeout_{60000};
 
 protected:
-  std::vector<sensor::Sensor *> pack_voltage_;
-  std::vector<sensor::Sensor *> current_;
-  std::vector<sensor::Sensor *> remaining_capacity_;
-  std::vector<sensor::Sensor *> total_capacity_;
-  std::vector<sensor::Sensor *> total_discharge_capacity_;
-  std::vector<sensor::Sensor *> soc_;
-  std::vector<sensor::Sensor *> soh_;
-  std::vector<sensor::Sensor *> cycle_count_;
-  std::vector<sensor::Sensor *> average_cell_voltage_;
-  std::vector<sensor::Sensor *> average_cell_temp_;
-  std::vector<sensor::Sensor *> max_cell_voltage_;
-  std::vector<sensor::Sensor *> min_cell_voltage_;
-  std::vector<sensor::Sensor *> max_cell_temp_;
-  std::vector<sensor::Sensor *> min_cell_temp_;
-  std::vector<sensor::Sensor *> maxdiscurt_;
-  std::vector<sensor::Sensor *> maxchgcurt_;
-  std::vector<sensor::Sensor *> cell_1_;
-  std::vector<sensor::Sensor *> cell_2_;
-  std::vector<sensor::Sensor *> cell_3_;
-  std::vector<sensor::Sensor *> cell_4_;
-  std::vector<sensor::Sensor *> cell_5_;
-  std::vector<sensor::Sensor *> cell_6_;
-  std::vector<sensor::Sensor *> cell_7_;
-  std::vector<sensor::Sensor *> cell_8_;
-  std::vector<sensor::Sensor *> cell_9_;
-  std::vector<sensor::Sensor *> cell_10_;
-  std::vector<sensor::Sensor *> cell_11_;
-  std::vector<sensor::Sensor *> cell_12_;
-  std::vector<sensor::Sensor *> cell_13_;
-  std::vector<sensor::Sensor *> cell_14_;
-  std::vector<sensor::Sensor *> cell_15_;
-  std::vector<sensor::Sensor *> cell_16_;
-  std::vector<sensor::Sensor *> cell_temp_1_;
-  std::vector<sensor::Sensor *> cell_temp_2_;
-  std::vector<sensor::Sensor *> cell_temp_3_;
-  std::vector<sensor::Sensor *> cell_temp_4_;
-  std::vector<sensor::Sensor *> case_temp_;
-  std::vector<sensor::Sensor *> power_temp_;
-  std::vector<text_sensor::TextSensor *> system_status_;
-  std::vector<text_sensor::TextSensor *> active_balancing_cells_;
-  std::vector<text_sensor::TextSensor *> cell_temperature_alarms_;
-  std::vector<text_sensor::TextSensor *> cell_voltage_alarms_;
-  std::vector<text_sensor::TextSensor *> FET_status_;
-  std::vector<text_sensor::TextSensor *> active_alarms_;
-  std::vector<text_sensor::TextSensor *> active_protections_;
+  // Ein RS-485-Strang mit eigenem Framing-Zustand. Dekodierung, Register und Auswertungen sind gemeinsam; ein Pack
+  // wird über (Bus, Adresse) gefunden und intern nur noch als BMS-Index first_pack + Adresse - 1 geführt.
+  struct Bus {
+    uart::UARTComponent *uart{nullptr};  // Bus 0: erst in setup() aus parent_
+    uint8_t first_pack{0};
+    uint8_t pack_count{0};
+    FrameScanner scanner;
+    uint32_t frame_gap_us{0};
+    uint32_t last_rx_us{0};
+    // Antwort, die wegen des Zeitbudgets erst in der nächsten loop() dekodiert wird; zeigt in den
+    // Scanner-Puffer und bleibt gültig, weil vorher nichts nachgelesen wird
+    ModbusFrame deferred_frame;
+    uint32_t deferred_arrival_us{0};
+    bool has_deferred_frame{false};
+  };
+  // Nach setup() nicht mehr verändert, damit die Verweise in deferred_frame gültig bleiben
+  std::vector<Bus> buses_;
+  size_t next_bus_{0};  // reihum zuerst gelesener Bus, damit keiner das Zeitbudget dauerhaft aufbraucht
+  // Zähler aller Scanner zusammen
+  FrameScannerStats scanner_stats_() const;
+
+  // Direkter Zugriff [BMS][Feld], Reihenfolge wie in seplos_registers.h
+  sensor::Sensor *field_sensors_[MAX_BMS_COUNT][SENSOR_FIELD_COUNT]{};
+  text_sensor::TextSensor *field_text_sensors_[MAX_BMS_COUNT][TEXT_FIELD_COUNT]{};
+  text_sensor::TextSensor *packed_sensors_[MAX_BMS_COUNT][BLOCK_COUNT]{};
+  uint32_t packed_last_time_[MAX_BMS_COUNT][BLOCK_COUNT]{};
+  void publish_packed_(int bms_index, BlockId block);
+
+  // Zuletzt dekodierter Wert je [BMS][Feld], unabhängig von Sensoren und Publish-Regeln; NaN = noch nie empfangen
+  float field_values_[MAX_BMS_COUNT][SENSOR_FIELD_COUNT];
+
+  // Zuletzt veröffentlichter Wert und Zeitpunkt je [BMS][Feld], NaN = noch nie veröffentlicht
+  PublishPolicy publish_policies_[FIELD_CLASS_COUNT];
+  float last_published_value_[MAX_BMS_COUNT][SENSOR_FIELD_COUNT];
+  uint32_t last_published_time_[MAX_BMS_COUNT][SENSOR_FIELD_COUNT]{};
+
+  void publish_fields_(const BlockDescriptor &block, const uint8_t *data, int bms_index, uint16_t first_register,
+                       uint16_t register_count);
+  void process_alarm_frame_(const uint8_t *bits, int bms_index);
+  void drain_rx_(uint32_t loop_start);
+  // false, wenn das Zeitbudget dieser loop() aufgebraucht ist
+  bool drain_bus_(int bus_index, uint32_t loop_start);
+  void update_bank_(int bms_index, BlockId block);
+  void publish_bank_();
+
+  void update_statistics_(int bms_index);
+  void publish_statistics_();
+  uint32_t current_day_();  // 0 ohne gültige Uhrzeit
+  uint32_t unix_time_();  // 0 ohne gültige Uhrzeit
+
+  struct StatisticBinding {
+    uint8_t bms_index;
+    StatQuantity quantity;
+    StatWindow window;
+    StatAggregation aggregation;
+    sensor::Sensor *sensor;
+  };
+  struct EnergyBinding {
+    uint8_t bms_index;
+    EnergyField field;
+    sensor::Sensor *sensor;
+  };
+  struct CellBinding {
+    uint8_t bms_index;
+    CellField field;
+    uint8_t cell;
+    sensor::Sensor *sensor;
+  };
+  std::vector<StatisticBinding> statistic_bindings_;
+  std::vector<EnergyBinding> energy_bindings_;
+  std::vector<CellBinding> cell_bindings_;
+  std::vector<PackStatistics> pack_statistics_;  // je BMS, in set_bms_count() angelegt
+  std::vector<ESPPreferenceObject> energy_preferences_;
+  bool restore_energy_{true};
+  std::string preference_key_;  // ID der Instanz
+#ifdef USE_TIME
+  time::RealTimeClock *time_{nullptr};
+#endif
+
+#ifdef USE_SEPLOS_UPLINK
+  void record_uplink_(int bms_index, BlockId block, const uint8_t *data);
+  void flush_uplink_();
+  // capture: Wert für X-Seplos-Capture, leer bei normalen Uploads
+  bool post_uplink_(const std::string &body, const std::string &capture = "");
+  // Ohne Verbindung: Inhalt des RAM-Puffers ins Flash-Journal verschieben
+  void spill_uplink_();
+  // Einen Stapel aus dem Journal senden, weitere folgen im Sekundenabstand
+  void drain_journal_();
+
+  http_request::HttpRequestComponent *uplink_http_{nullptr};
+  std::string uplink_url_;
+  std::string uplink_api_key_;
+  size_t uplink_buffer_size_{16384};
+  uint32_t uplink_sample_interval_{5000};
+  uint32_t uplink_flush_interval_{300000};
+  UplinkRing uplink_;
+  uint32_t uplink_last_sample_[MAX_BMS_COUNT][BLOCK_COUNT]{};
+  uint32_t uplink_failures_{0};
+#ifdef USE_ESP32
+  std::string journal_partition_;
+  PartitionJournalStorage journal_storage_;
+#endif
+  Journal journal_;
+  bool journal_ready_{false};
+#endif
+
+  std::vector<CaptureRing> captures_;  // je BMS, leer ohne capture:
+  // Abholen und Scharfschalten laufen auch im Task des Webservers, nicht nur in loop()
+  mutable Mutex capture_lock_;
+  uint16_t capture_pre_trigger_{0};
+  uint16_t capture_post_trigger_{0};
+  uint8_t capture_mask_[ALARM_BYTES]{};
+#ifdef USE_SEPLOS_CAPTURE_WEB
+  // GET /seplos/capture?bms=N liefert die Aufzeichnung, POST schaltet sie neu scharf
+  class CaptureHandler : public AsyncWebHandler {
+   public:
+    explicit CaptureHandler(SeplosParser *parent) : parent_(parent) {}
+    bool canHandle(AsyncWebServerRequest *request) override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+
+   protected:
+    SeplosParser *parent_;
+  };
+#endif
+
+  void tick_history_();
+  std::vector<SensorField> history_fields_;
+  size_t history_slots_{0};
+  std::vector<HistoryRing> histories_;  // je BMS, leer ohne history:
+  // Die Abfrage läuft im Task des Webservers, nicht in loop()
+  Mutex history_lock_;
+#ifdef USE_SEPLOS_HISTORY
+  // GET /seplos/history?bms=N&from=&to=&fields=a,b streamt den Minutenverlauf als JSON
+  class HistoryHandler : public AsyncWebHandler {
+   public:
+    explicit HistoryHandler(SeplosParser *parent) : parent_(parent) {}
+    bool canHandle(AsyncWebServerRequest *request) override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+
+   protected:
+    SeplosParser *parent_;
+  };
+#endif
+
+  void poll_master_();
+  // DE/RE zurück auf Empfang, sobald die Anfrage vollständig gesendet ist
+  void release_flow_control_(uint32_t now);
+  void update_master_alarm_(int bms_index, const uint8_t *bits);
+  bool master_{false};
+  PollScheduler scheduler_;
+  GPIOPin *flow_control_pin_{nullptr};
+  bool flow_control_active_{false};
+  uint32_t flow_control_release_at_{0};  // micros()
+  // Bis zum Umschalten läuft loop() ohne Pause, damit die Antwort nicht auf einen sendenden Treiber trifft
+  HighFrequencyLoopRequester tx_high_freq_;
+  // Letzter Strom je Pack; ein Sprung zieht die Alarmabfrage vor
+  float master_current_[MAX_BMS_COUNT];
+  uint64_t master_airtime_at_last_rate_{0};
+
+  BankAggregator bank_;
+  sensor::Sensor *bank_sensors_[BANK_FIELD_COUNT]{};
+  float bank_last_value_[BANK_FIELD_COUNT];
+  uint32_t bank_last_time_[BANK_FIELD_COUNT]{};
+  void publish_diagnostics_();
+  void sample_heap_();
+
+  sensor::Sensor *diagnostic_sensors_[DIAGNOSTIC_COUNT]{};
+  sensor::Sensor *pack_diagnostic_sensors_[MAX_BMS_COUNT][PACK_DIAGNOSTIC_COUNT]{};
+  uint32_t frames_per_block_[BLOCK_COUNT]{};
+  uint32_t frames_per_bms_[MAX_BMS_COUNT]{};
+  uint32_t frames_at_last_rate_[MAX_BMS_COUNT]{};
+  uint32_t last_rate_time_{0};
+  uint32_t last_seen_[MAX_BMS_COUNT][BLOCK_COUNT]{};
+  bool online_[MAX_BMS_COUNT]{};
+  void update_online_(int bms_index, bool online);
+  void check_staleness_();
+  uint32_t invalid_bms_ids_{0};
+  TimeHistogram loop_time_;
+  TimeHistogram publish_latency_;  // vom Lesen des letzten Frame-Bytes bis nach dem Veröffentlichen
+  uint32_t free_heap_{0};
+  uint32_t min_free_heap_{0};
+  uint32_t frames_deferred_{0};
+  uint32_t uart_overruns_{0};        // loop()-Aufrufe, bei denen ein UART-Empfangspuffer voll war
+  size_t uart_backlog_max_{0};       // größter Rückstand eines UART-Puffers seit der letzten Veröffentlichung
+  void alarm_text_bytes_(TextField field, uint8_t *from, uint8_t *to);
+  void render_alarm_text_(TextField field, const uint8_t *bits);
+
+  // Letzte empfangene und zuletzt als Text veröffentlichte Alarm-Bytes je BMS
+  uint8_t alarm_bits_[MAX_BMS_COUNT][ALARM_BYTES]{};
+  uint8_t alarm_published_bits_[MAX_BMS_COUNT][ALARM_BYTES]{};
+  bool alarm_received_[MAX_BMS_COUNT]{};
+  bool alarm_text_published_[MAX_BMS_COUNT]{};
+  std::string text_buffer_;  // in setup() vorbelegt
 };
 
 }  // namespace seplos_parser
@@ -0,0 +1,313 @@
+#pragma once
+
+// Registerbelegung der Seplos-V3-Antworten. Jede Zeile beschreibt genau einen Messwert;
+// __init__.py liest diese Datei ebenfalls ein, ein neues Register braucht also nur eine neue Zeile.
+//
+// F(ENUM, name, offset, signedness, divisor, add, class)
+//   offset:  Byte-Offset des 16-Bit-Werts (Big Endian) ab Frame-Anfang (Adresse, Funktion, Länge, Daten...)
+//   wert = roh / divisor + add
+//   class:   Feldklasse für die Publish-Regeln (FieldClass)
+
+#include "seplos_frame.h"
+#include <cstddef>
+#include <cstdint>
+
+// Antwort mit 0x24 Datenbytes (36)
+#define SEPLOS_PIA_FIELDS(F) \
+  F(PACK_VOLTAGE,             pack_voltage,              3, UNSIGNED,  100.0f,    0.0f, VOLTAGE) \
+  F(CURRENT,                  current,                   5, SIGNED,    100.0f,    0.0f, CURRENT) \
+  F(REMAINING_CAPACITY,       remaining_capacity,        7, UNSIGNED,  100.0f,    0.0f, CAPACITY) \
+  F(TOTAL_CAPACITY,           total_capacity,            9, UNSIGNED,  100.0f,    0.0f, CAPACITY) \
+  F(TOTAL_DISCHARGE_CAPACITY, total_discharge_capacity, 11, UNSIGNED,    0.1f,    0.0f, CAPACITY) \
+  F(SOC,                      soc,                      13, UNSIGNED,   10.0f,    0.0f, PERCENT) \
+  F(SOH,                      soh,                      15, UNSIGNED,   10.0f,    0.0f, PERCENT) \
+  F(CYCLE_COUNT,              cycle_count,              17, UNSIGNED,    1.0f,    0.0f, COUNTER) \
+  F(AVERAGE_CELL_VOLTAGE,     average_cell_voltage,     19, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(AVERAGE_CELL_TEMP,        average_cell_temp,        21, UNSIGNED,   10.0f, -273.15f, TEMPERATURE) \
+  F(MAX_CELL_VOLTAGE,         max_cell_voltage,         23, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(MIN_CELL_VOLTAGE,         min_cell_voltage,         25, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(MAX_CELL_TEMP,            max_cell_temp,            27, UNSIGNED,   10.0f, -273.15f, TEMPERATURE) \
+  F(MIN_CELL_TEMP,            min_cell_temp,            29, UNSIGNED,   10.0f, -273.15f, TEMPERATURE) \
+  F(MAXDISCURT,               maxdiscurt,               33, UNSIGNED,    1.0f,    0.0f, CURRENT) \
+  F(MAXCHGCURT,               maxchgcurt,               35, UNSIGNED,    1.0f,    0.0f, CURRENT)
+
+// Antwort mit 0x34 Datenbytes (52)
+#define SEPLOS_PIB_FIELDS(F) \
+  F(CELL_1,                   cell_1,                    3, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_2,                   cell_2,                    5, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_3,                   cell_3,                    7, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_4,                   cell_4,                    9, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_5,                   cell_5,                   11, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_6,                   cell_6,                   13, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_7,                   cell_7,                   15, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_8,                   cell_8,                   17, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_9,                   cell_9,                   19, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_10,                  cell_10,                  21, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_11,                  cell_11,                  23, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_12,                  cell_12,                  25, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_13,                  cell_13,                  27, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_14,                  cell_14,                  29, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_15,                  cell_15,                  31, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_16,                  cell_16,                  33, UNSIGNED, 1000.0f,    0.0f, CELL_VOLTAGE) \
+  F(CELL_TEMP_1,              cell_temp_1,              35, UNSIGNED,   10.0f, -273.15f, TEMPERATURE) \
+  F(CELL_TEMP_2,              cell_temp_2,              37, UNSIGNED,   10.0f, -273.15f, TEMPERATURE) \
+  F(CELL_TEMP_3,              cell_temp_3,              39, UNSIGNED,   10.0f, -273.15f, TEMPERATURE) \
+  F(CELL_TEMP_4,              cell_temp_4,              41, UNSIGNED,   10.0f, -273.15f, TEMPERATURE) \
+  F(CASE_TEMP,                case_temp,                51, UNSIGNED,   10.0f, -273.15f, TEMPERATURE) \
+  F(POWER_TEMP,               power_temp,               53, UNSIGNED,   10.0f, -273.15f, TEMPERATURE)
+
+// Textwerte aus der Antwort mit 0x12 Datenbytes (18)
+#define SEPLOS_TEXT_FIELDS(F) \
+  F(SYSTEM_STATUS,            system_status) \
+  F(ACTIVE_BALANCING_CELLS,   active_balancing_cells) \
+  F(CELL_TEMPERATURE_ALARMS,  cell_temperature_alarms) \
+  F(CELL_VOLTAGE_ALARMS,      cell_voltage_alarms) \
+  F(FET_STATUS,               FET_status) \
+  F(ACTIVE_ALARMS,            active_alarms) \
+  F(ACTIVE_PROTECTIONS,       active_protections)
+
+// Einzelbits der Antwort mit 0x12 Datenbytes, in der Reihenfolge der Textausgabe
+// F(ENUM, name, byte, mask, kind, text)
+//   byte: Byte-Offset ab Frame-Anfang, kind: Textfeld, in dem das Bit erscheint
+#define SEPLOS_ALARM_BITS(F) \
+  F(DISCHARGE,                                      discharge,                                      11, 0x01, STATUS,    "Discharge") \
+  F(CHARGE,                                         charge,                                         11, 0x02, STATUS,    "Charge") \
+  F(FLOATING_CHARGE,                                floating_charge,                                11, 0x04, STATUS,    "Floating Charge") \
+  F(FULL_CHARGE,                                    full_charge,                                    11, 0x08, STATUS,    "Full Charge") \
+  F(STANDBY_MODE,                                   standby_mode,                                   11, 0x10, STATUS,    "Standby Mode") \
+  F(TURN_OFF,                                       turn_off,                                       11, 0x20, STATUS,    "Turn Off") \
+  F(CELL_HIGH_VOLTAGE_ALARM,                        cell_high_voltage_alarm,                        12, 0x01, ALARM,     "Cell High Voltage Alarm") \
+  F(CELL_OVER_VOLTAGE_PROTECTION,                   cell_over_voltage_protection,                   12, 0x02, PROTECTION, "Cell Over Voltage Protection") \
+  F(CELL_LOW_VOLTAGE_ALARM,                         cell_low_voltage_alarm,                         12, 0x04, ALARM,     "Cell Low Voltage Alarm") \
+  F(CELL_UNDER_VOLTAGE_PROTECTION,                  cell_under_voltage_protection,                  12, 0x08, PROTECTION, "Cell Under Voltage Protection") \
+  F(PACK_HIGH_VOLTAGE_ALARM,                        pack_high_voltage_alarm,                        12, 0x10, ALARM,     "Pack High Voltage Alarm") \
+  F(PACK_OVER_VOLTAGE_PROTECTION,                   pack_over_voltage_protection,                   12, 0x20, PROTECTION, "Pack Over Voltage Protection") \
+  F(PACK_LOW_VOLTAGE_ALARM,                         pack_low_voltage_alarm,                         12, 0x40, ALARM,     "Pack Low Voltage Alarm") \
+  F(PACK_UNDER_VOLTAGE_PROTECTION,                  pack_under_voltage_protection,                  12, 0x80, PROTECTION, "Pack Under Voltage Protection") \
+  F(CHARGE_HIGH_TEMPERATURE_ALARM,                  charge_high_temperature_alarm,                  13, 0x01, ALARM,     "Charge High Temperature Alarm") \
+  F(CHARGE_HIGH_TEMPERATURE_PROTECTION,             charge_high_temperature_protection,             13, 0x02, PROTECTION, "Charge High Temperature Protection") \
+  F(CHARGE_LOW_TEMPERATURE_ALARM,                   charge_low_temperature_alarm,                   13, 0x04, ALARM,     "Charge Low Temperature Alarm") \
+  F(CHARGE_UNDER_TEMPERATURE_PROTECTION,            charge_under_temperature_protection,            13, 0x08, PROTECTION, "Charge Under Temperature Protection") \
+  F(DISCHARGE_HIGH_TEMPERATURE_ALARM,               discharge_high_temperature_alarm,               13, 0x10, ALARM,     "Discharge High Temperature Alarm") \
+  F(DISCHARGE_OVER_TEMPERATURE_PROTECTION,          discharge_over_temperature_protection,          13, 0x20, PROTECTION, "Discharge Over Temperature Protection") \
+  F(DISCHARGE_LOW_TEMPERATURE_ALARM,                discharge_low_temperature_alarm,                13, 0x40, ALARM,     "Discharge Low Temperature Alarm") \
+  F(DISCHARGE_UNDER_TEMPERATURE_PROTECTION,         discharge_under_temperature_protection,         13, 0x80, PROTECTION, "Discharge Under Temperature Protection") \
+  F(HIGH_ENVIRONMENT_TEMPERATURE_ALARM,             high_environment_temperature_alarm,             14, 0x01, ALARM,     "High Environment Temperature Alarm") \
+  F(OVER_ENVIRONMENT_TEMPERATURE_PROTECTION,        over_environment_temperature_protection,        14, 0x02, PROTECTION, "Over Environment Temperature Protection") \
+  F(LOW_ENVIRONMENT_TEMPERATURE_ALARM,              low_environment_temperature_alarm,              14, 0x04, ALARM,     "Low Environment Temperature Alarm") \
+  F(UNDER_ENVIRONMENT_TEMPERATURE_PROTECTION,       under_environment_temperature_protection,       14, 0x08, PROTECTION, "Under Environment Temperature Protection") \
+  F(HIGH_POWER_TEMPERATURE_ALARM,                   high_power_temperature_alarm,                   14, 0x10, ALARM,     "High Power Temperature Alarm") \
+  F(OVER_POWER_TEMPERATURE_PROTECTION,              over_power_temperature_protection,              14, 0x20, PROTECTION, "Over Power Temperature Protection") \
+  F(CELL_TEMPERATURE_LOW_HEATING,                   cell_temperature_low_heating,                   14, 0x40, ALARM,     "Cell Temperature Low Heating") \
+  F(CHARGE_CURRENT_ALARM,                           charge_current_alarm,                           15, 0x01, ALARM,     "Charge Current Alarm") \
+  F(CHARGE_OVER_CURRENT_PROTECTION,                 charge_over_current_protection,                 15, 0x02, PROTECTION, "Charge Over Current Protection") \
+  F(CHARGE_SECOND_LEVEL_CURRENT_PROTECTION,         charge_second_level_current_protection,         15, 0x04, PROTECTION, "Charge Second Level Current Protection") \
+  F(DISCHARGE_CURRENT_ALARM,                        discharge_current_alarm,                        15, 0x08, ALARM,     "Discharge Current Alarm") \
+  F(DISCHARGE_OVER_CURRENT_PROTECTION,              discharge_over_current_protection,              15, 0x10, PROTECTION, "Discharge Over Current Protection") \
+  F(DISCHARGE_SECOND_LEVEL_OVER_CURRENT_PROTECTION, discharge_second_level_over_current_protection, 15, 0x20, PROTECTION, "Discharge Second Level Over Current Protection") \
+  F(OUTPUT_SHORT_CIRCUIT_PROTECTION,                output_short_circuit_protection,                15, 0x40, PROTECTION, "Output Short Circuit Protection") \
+  F(OUTPUT_SHORT_LATCH_UP,                          output_short_latch_up,                          16, 0x01, ALARM,     "Output Short Latch Up") \
+  F(SECOND_CHARGE_LATCH_UP,                         second_charge_latch_up,                         16, 0x04, ALARM,     "Second Charge Latch Up") \
+  F(SECOND_DISCHARGE_LATCH_UP,                      second_discharge_latch_up,                      16, 0x08, ALARM,     "Second Discharge Latch Up") \
+  F(SOC_ALARM,                                      soc_alarm,                                      17, 0x04, ALARM,     "SOC Alarm") \
+  F(SOC_PROTECTION,                                 soc_protection,                                 17, 0x08, PROTECTION, "SOC Protection") \
+  F(CELL_DIFFERENCE_ALARM,                          cell_difference_alarm,                          17, 0x10, ALARM,     "Cell Difference Alarm") \
+  F(DISCHARGE_FET_ON,                               discharge_fet_on,                               18, 0x01, FET,       "Discharge FET On") \
+  F(CHARGE_FET_ON,                                  charge_fet_on,                                  18, 0x02, FET,       "Charge FET On") \
+  F(CURRENT_LIMITING_FET_ON,                        current_limiting_fet_on,                        18, 0x04, FET,       "Current Limiting FET On") \
+  F(HEATING_ON,                                     heating_on,                                     18, 0x08, FET,       "Heating On") \
+  F(LOW_SOC_ALARM,                                  low_soc_alarm,                                  19, 0x01, ALARM,     "Low SOC Alarm") \
+  F(INTERMITTENT_CHARGE,                            intermittent_charge,                            19, 0x02, ALARM,     "Intermittent Charge") \
+  F(EXTERNAL_SWITCH_CONTROL,                        external_switch_control,                        19, 0x04, ALARM,     "External Switch Conrol") \
+  F(STATIC_STANDBY_SLEEP_MODE,                      static_standby_sleep_mode,                      19, 0x08, ALARM,     "Static Standy Sleep Mode") \
+  F(HISTORY_DATA_RECORDING,                         history_data_recording,                         19, 0x10, ALARM,     "History Data Recording") \
+  F(UNDER_SOC_PROTECTION,                           under_soc_protection,                           19, 0x20, PROTECTION, "Under SOC Protections") \
+  F(ACTIVE_LIMITED_CURRENT,                         active_limited_current,                         19, 0x40, ALARM,     "Active Limited Current") \
+  F(PASSIVE_LIMITED_CURRENT,                        passive_limited_current,                        19, 0x80, ALARM,     "Passive Limited Current") \
+  F(NTC_FAULT,                                      ntc_fault,                                      20, 0x01, PROTECTION, "NTC Fault") \
+  F(AFE_FAULT,                                      afe_fault,                                      20, 0x02, PROTECTION, "AFE Fault") \
+  F(CHARGE_MOSFET_FAULT,                            charge_mosfet_fault,                            20, 0x04, PROTECTION, "Charge Mosfet Fault") \
+  F(DISCHARGE_MOSFET_FAULT,                         discharge_mosfet_fault,                         20, 0x08, PROTECTION, "Discharge Mosfet Fault") \
+  F(CELL_FAULT,                                     cell_fault,                                     20, 0x10, PROTECTION, "Cell Fault") \
+  F(BREAK_LINE_FAULT,                               break_line_fault,                               20, 0x20, PROTECTION, "Break Line Fault") \
+  F(KEY_FAULT,                                      key_fault,                                      20, 0x40, PROTECTION, "Key Fault") \
+  F(AEROSOL_ALARM,                                  aerosol_alarm,                                  20, 0x80, PROTECTION, "Aerosol Alarm")
+
+namespace esphome {
+namespace seplos_parser {
+
+// Packs über alle Busse eines Parsers. Die Felder je Pack sind fest dimensioniert; __init__.py setzt
+// -DSEPLOS_MAX_BMS_COUNT=48 nur, wenn mehrere Busse zusammen mehr als 16 Packs tragen.
+#ifndef SEPLOS_MAX_BMS_COUNT
+#define SEPLOS_MAX_BMS_COUNT 16
+#endif
+static const int MAX_BMS_COUNT = SEPLOS_MAX_BMS_COUNT;
+// Adressen 0x01-0x10 je Bus
+static const int MAX_BUS_ADDRESSES = 16;
+
+#define SEPLOS_FIELD_ENUM(key, name, ...) SENSOR_##key,
+enum SensorField : uint8_t {
+  SEPLOS_PIA_FIELDS(SEPLOS_FIELD_ENUM)
+  SEPLOS_PIB_FIELDS(SEPLOS_FIELD_ENUM)
+  SENSOR_FIELD_COUNT
+};
+#undef SEPLOS_FIELD_ENUM
+
+#define SEPLOS_TEXT_FIELD_ENUM(key, name) TEXT_##key,
+enum TextField : uint8_t {
+  SEPLOS_TEXT_FIELDS(SEPLOS_TEXT_FIELD_ENUM)
+  TEXT_FIELD_COUNT
+};
+#undef SEPLOS_TEXT_FIELD_ENUM
+
+enum FieldClass : uint8_t {
+  CLASS_VOLTAGE,
+  CLASS_CELL_VOLTAGE,
+  CLASS_CURRENT,
+  CLASS_TEMPERATURE,
+  CLASS_CAPACITY,
+  CLASS_PERCENT,
+  CLASS_COUNTER,
+  CLASS_POWER,  // nur Bank-Leistung (W)
+  FIELD_CLASS_COUNT
+};
+
+struct FieldDescriptor {
+  uint8_t offset;
+  uint8_t width;  // Bytes, alle Seplos-Register sind 16 Bit breit
+  bool is_signed;
+  float divisor;
+  float add;
+  SensorField field;
+  FieldClass field_class;
+};
+
+#define SEPLOS_DESCRIPTOR(key, name, offset, signedness, divisor, add, field_class) \
+  {offset, 2, SEPLOS_##signedness, divisor, add, SENSOR_##key, CLASS_##field_class},
+#define SEPLOS_SIGNED true
+#define SEPLOS_UNSIGNED false
+static constexpr FieldDescriptor PIA_FIELDS[] = {SEPLOS_PIA_FIELDS(SEPLOS_DESCRIPTOR)};
+static constexpr FieldDescriptor PIB_FIELDS[] = {SEPLOS_PIB_FIELDS(SEPLOS_DESCRIPTOR)};
+#undef SEPLOS_SIGNED
+#undef SEPLOS_UNSIGNED
+#undef SEPLOS_DESCRIPTOR
+
+#define SEPLOS_FIELD_NAME(key, name, ...) #name,
+static constexpr const char *SENSOR_FIELD_NAMES[SENSOR_FIELD_COUNT] = {
+  SEPLOS_PIA_FIELDS(SEPLOS_FIELD_NAME)
+  SEPLOS_PIB_FIELDS(SEPLOS_FIELD_NAME)
+};
+#undef SEPLOS_FIELD_NAME
+
+#define SEPLOS_TEXT_FIELD_NAME(key, name) #name,
+static constexpr const char *TEXT_FIELD_NAMES[TEXT_FIELD_COUNT] = {SEPLOS_TEXT_FIELDS(SEPLOS_TEXT_FIELD_NAME)};
+#undef SEPLOS_TEXT_FIELD_NAME
+
+// Wann ein neuer Wert einer Feldklasse veröffentlicht wird
+struct PublishPolicy {
+  uint32_t min_interval{0};    // ms, schneller wird nie veröffentlicht
+  float deadband{0.0f};        // absolute Mindeständerung
+  float relative_deadband{0.0f};  // Mindeständerung relativ zum zuletzt veröffentlichten Wert
+  uint32_t max_silence{60000};  // ms, danach wird auch ein unveränderter Wert erneut gesendet (0 = nie)
+
+  bool should_publish(float last_value, uint32_t elapsed, float value) const {
+    if (last_value != last_value) {
+      return true;  // noch nie veröffentlicht (NaN)
+    }
+    if (elapsed < min_interval) {
+      return false;
+    }
+    if (max_silence > 0 && elapsed >= max_silence) {
+      return true;
+    }
+    float delta = value > last_value ? value - last_value : last_value - value;
+    float limit = deadband;
+    float relative = relative_deadband * (last_value < 0 ? -last_value : last_value);
+    if (relative > limit) {
+      limit = relative;
+    }
+    return limit > 0.0f ? delta >= limit : delta > 0.0f;
+  }
+};
+
+// Die 0x12-Antwort wird als Bitmaske der Datenbytes 3-20 gehalten
+static const uint8_t ALARM_FIRST_BYTE = 3;
+static const uint8_t ALARM_BYTES = 18;
+
+enum AlarmKind : uint8_t { ALARM_KIND_STATUS, ALARM_KIND_ALARM, ALARM_KIND_PROTECTION, ALARM_KIND_FET };
+
+#define SEPLOS_ALARM_ENUM(key, ...) ALARM_##key,
+enum AlarmBit : uint8_t {
+  SEPLOS_ALARM_BITS(SEPLOS_ALARM_ENUM)
+  ALARM_BIT_COUNT
+};
+#undef SEPLOS_ALARM_ENUM
+
+struct AlarmDescriptor {
+  uint8_t byte;
+  uint8_t mask;
+  AlarmKind kind;
+  const char *text;
+};
+
+#define SEPLOS_ALARM_DESCRIPTOR(key, name, byte, mask, kind, text) {byte, mask, ALARM_KIND_##kind, text},
+static constexpr AlarmDescriptor ALARM_DESCRIPTORS[ALARM_BIT_COUNT] = {SEPLOS_ALARM_BITS(SEPLOS_ALARM_DESCRIPTOR)};
+#undef SEPLOS_ALARM_DESCRIPTOR
+
+// Registerblöcke, die der Master abfragt: Funktion, Startadresse und Anzahl Register/Bits.
+// Die Feld-Offsets oben gelten für eine Antwort auf den ganzen Block.
+enum BlockId : uint8_t { BLOCK_PIA, BLOCK_PIB, BLOCK_PIC, BLOCK_COUNT };
+
+struct BlockDescriptor {
+  BlockId id;
+  uint8_t function;
+  uint16_t start;
+  uint16_t count;
+  const FieldDescriptor *fields;  // nullptr für den Bit-Block (Alarme)
+  uint8_t field_count;
+};
+
+static constexpr BlockDescriptor BLOCKS[BLOCK_COUNT] = {
+  {BLOCK_PIA, 0x04, 0x1000, 18, PIA_FIELDS, sizeof(PIA_FIELDS) / sizeof(PIA_FIELDS[0])},
+  {BLOCK_PIB, 0x04, 0x1100, 26, PIB_FIELDS, sizeof(PIB_FIELDS) / sizeof(PIB_FIELDS[0])},
+  {BLOCK_PIC, 0x01, 0x1200, 144, nullptr, 0},
+};
+
+// Block, in dem eine gepaarte Leseanfrage liegt. Register-Blöcke dürfen auch teilweise gelesen werden,
+// der Bit-Block nur ab seinem Anfang.
+inline const BlockDescriptor *find_block(uint8_t function, uint16_t start, uint16_t count) {
+  for (const BlockDescriptor &block : BLOCKS) {
+    if (block.function != function || start < block.start) {
+      continue;
+    }
+    if (block.fields == nullptr ? start == block.start && count >= block.count
+                                : start + count <= block.start + block.count) {
+      return &block;
+    }
+  }
+  return nullptr;
+}
+
+// Ohne mitgelesene Anfrage: Block, dessen vollständige Antwort genau byte_count Datenbytes hat
+inline const BlockDescriptor *find_block_by_shape(uint8_t function, uint8_t byte_count) {
+  for (const BlockDescriptor &block : BLOCKS) {
+    if (block.function == function && expected_byte_count(block.function, block.count) == byte_count) {
+      return &block;
+    }
+  }
+  return nullptr;
+}
+
+// value zeigt auf das erste Byte des 16-Bit-Registers
+inline float decode_register(const FieldDescriptor &desc, const uint8_t *value) {
+  uint16_t raw = (value[0] << 8) | value[1];
+  float decoded = desc.is_signed ? float(int16_t(raw)) : float(raw);
+  return decoded / desc.divisor + desc.add;
+}
+
+inline float decode_field(const FieldDescriptor &desc, const uint8_t *frame) {
+  return decode_register(desc, frame + desc.offset);
+}
+
+}  // namespace seplos_parser
+}  // namespace esphome
@@ -0,0 +1,109 @@
+#include "seplos_stats.h"
+#include <cmath>
+
+namespace esphome {
+namespace seplos_parser {
+
+void RollingWindow::add(uint32_t now, float value) {
+  uint32_t epoch = now / bucket_ms_;
+  Bucket &bucket = buckets_[epoch % BUCKETS];
+  if (bucket.epoch != epoch) {
+    bucket.epoch = epoch;
+    bucket.min = value;
+    bucket.max = value;
+    bucket.sum = 0.0f;
+    bucket.count = 0;
+  }
+  bucket.min = value < bucket.min ? value : bucket.min;
+  bucket.max = value > bucket.max ? value : bucket.max;
+  bucket.sum += value;
+  bucket.count++;
+}
+
+bool RollingWindow::get(uint32_t now, float *min, float *max, float *mean) const {
+  uint32_t epoch = now / bucket_ms_;
+  float sum = 0.0f;
+  uint32_t count = 0;
+  for (const Bucket &bucket : buckets_) {
+    if (bucket.count == 0 || epoch - bucket.epoch >= BUCKETS) {
+      continue;  // leer oder aus dem Fenster gefallen
+    }
+    if (count == 0 || bucket.min < *min) {
+      *min = bucket.min;
+    }
+    if (count == 0 || bucket.max > *max) {
+      *max = bucket.max;
+    }
+    sum += bucket.sum;
+    count += bucket.count;
+  }
+  if (count == 0) {
+    return false;
+  }
+  *mean = sum / count;
+  return true;
+}
+
+void EnergyCounter::add_sample(uint32_t now, float pack_voltage, float current) {
+  int32_t voltage = int32_t(lroundf(pack_voltage * 100.0f));
+  int32_t amps = int32_t(lroundf(current * 100.0f));
+  if (has_last_) {
+    // millis() läuft nach 49 Tagen über, die Differenz bleibt trotzdem richtig
+    uint32_t dt = now - last_time_;
+    if (dt <= max_gap_ms_) {
+      uint32_t first_half = dt / 2;
+      accumulate_(last_voltage_, last_current_, first_half);
+      accumulate_(voltage, amps, dt - first_half);
+    }
+  }
+  last_time_ = now;
+  last_voltage_ = voltage;
+  last_current_ = amps;
+  has_last_ = true;
+}
+
+void EnergyCounter::accumulate_(int32_t voltage, int32_t current, uint32_t dt) {
+  int64_t charge = int64_t(current) * dt;
+  int64_t energy = charge * voltage;
+  if (charge >= 0) {
+    state_.charged_charge += charge;
+    state_.charged_charge_today += charge;
+    state_.charged_energy += energy;
+    state_.charged_energy_today += energy;
+  } else {
+    state_.discharged_charge -= charge;
+    state_.discharged_charge_today -= charge;
+    state_.discharged_energy -= energy;
+    state_.discharged_energy_today -= energy;
+  }
+}
+
+void EnergyCounter::start_day(uint32_t day) {
+  if (state_.day == day) {
+    return;
+  }
+  state_.day = day;
+  state_.charged_charge_today = 0;
+  state_.discharged_charge_today = 0;
+  state_.charged_energy_today = 0;
+  state_.discharged_energy_today = 0;
+}
+
+float EnergyCounter::get(EnergyField field) const {
+  static const double AH = 100.0 * 3600000.0;            // cA·ms je Ah
+  static const double WH = 10000.0 * 3600000.0;          // 0,0001 W·ms je Wh
+  switch (field) {
+    case ENERGY_CHARGED_AH: return state_.charged_charge / AH;
+    case ENERGY_DISCHARGED_AH: return state_.discharged_charge / AH;
+    case ENERGY_CHARGED_WH: return state_.charged_energy / WH;
+    case ENERGY_DISCHARGED_WH: return state_.discharged_energy / WH;
+    case ENERGY_CHARGED_AH_TODAY: return state_.charged_charge_today / AH;
+    case ENERGY_DISCHARGED_AH_TODAY: return state_.discharged_charge_today / AH;
+    case ENERGY_CHARGED_WH_TODAY: return state_.charged_energy_today / WH;
+    case ENERGY_DISCHARGED_WH_TODAY: return state_.discharged_energy_today / WH;
+    default: return NAN;
+  }
+}
+
+}  // namespace seplos_parser
+}  // namespace esphome
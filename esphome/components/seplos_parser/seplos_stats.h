@@ -0,0 +1,138 @@
+#pragma once
+
+// Energiezähler und gleitende Statistiken je Pack. Reines C++ wie seplos_frame.h.
+
+#include "seplos_cells.h"
+#include <cstdint>
+
+// Größen mit gleitender Min/Max/Mittelwert-Statistik, F(ENUM, name)
+#define SEPLOS_STAT_QUANTITIES(F) \
+  F(CURRENT,      current) \
+  F(PACK_VOLTAGE, pack_voltage) \
+  F(CELL_DELTA,   cell_delta)
+
+// Fensterlängen, F(ENUM, name, ms)
+#define SEPLOS_STAT_WINDOWS(F) \
+  F(1M,  1m,  60000UL) \
+  F(15M, 15m, 900000UL) \
+  F(24H, 24h, 86400000UL)
+
+// Energiezähler, F(ENUM, name); *_today setzt time_id voraus und beginnt um Mitternacht Ortszeit neu
+#define SEPLOS_ENERGY_FIELDS(F) \
+  F(CHARGED_AH,          charged_ah) \
+  F(DISCHARGED_AH,       discharged_ah) \
+  F(CHARGED_WH,          charged_wh) \
+  F(DISCHARGED_WH,       discharged_wh) \
+  F(CHARGED_AH_TODAY,    charged_ah_today) \
+  F(DISCHARGED_AH_TODAY, discharged_ah_today) \
+  F(CHARGED_WH_TODAY,    charged_wh_today) \
+  F(DISCHARGED_WH_TODAY, discharged_wh_today)
+
+namespace esphome {
+namespace seplos_parser {
+
+#define SEPLOS_STAT_QUANTITY_ENUM(key, name) STAT_##key,
+enum StatQuantity : uint8_t {
+  SEPLOS_STAT_QUANTITIES(SEPLOS_STAT_QUANTITY_ENUM)
+  STAT_QUANTITY_COUNT
+};
+#undef SEPLOS_STAT_QUANTITY_ENUM
+
+#define SEPLOS_STAT_WINDOW_ENUM(key, name, ms) WINDOW_##key,
+enum StatWindow : uint8_t {
+  SEPLOS_STAT_WINDOWS(SEPLOS_STAT_WINDOW_ENUM)
+  STAT_WINDOW_COUNT
+};
+#undef SEPLOS_STAT_WINDOW_ENUM
+
+#define SEPLOS_STAT_WINDOW_MS(key, name, ms) ms,
+static constexpr uint32_t STAT_WINDOW_MS[STAT_WINDOW_COUNT] = {SEPLOS_STAT_WINDOWS(SEPLOS_STAT_WINDOW_MS)};
+#undef SEPLOS_STAT_WINDOW_MS
+
+enum StatAggregation : uint8_t { AGG_MIN, AGG_MAX, AGG_MEAN, STAT_AGGREGATION_COUNT };
+
+#define SEPLOS_ENERGY_ENUM(key, name) ENERGY_##key,
+enum EnergyField : uint8_t {
+  SEPLOS_ENERGY_FIELDS(SEPLOS_ENERGY_ENUM)
+  ENERGY_FIELD_COUNT
+};
+#undef SEPLOS_ENERGY_ENUM
+
+// Gleitendes Fenster aus BUCKETS Zeitscheiben mit je Min/Max/Summe: fester Speicher, add() in O(1).
+// Das ausgewertete Fenster umfasst die laufende und die BUCKETS-1 vorherigen Scheiben, also
+// zwischen (BUCKETS-1)/BUCKETS und der vollen Fensterlänge.
+class RollingWindow {
+ public:
+  static const int BUCKETS = 6;
+
+  void set_window(uint32_t window_ms) { bucket_ms_ = window_ms / BUCKETS; }
+  void add(uint32_t now, float value);
+  // false, wenn im Fenster kein Wert liegt
+  bool get(uint32_t now, float *min, float *max, float *mean) const;
+
+ protected:
+  struct Bucket {
+    uint32_t epoch{UINT32_MAX};  // now / bucket_ms_ der Scheibe
+    float min;
+    float max;
+    float sum;
+    uint32_t count;
+  };
+
+  uint32_t bucket_ms_{1};
+  Bucket buckets_[BUCKETS];
+};
+
+// Persistenter Zustand eines Energiezählers (ESPHome-Preferences), Festkomma:
+// Ladung in cA·ms, Energie in 0,0001 W·ms
+struct EnergyState {
+  int64_t charged_charge;
+  int64_t discharged_charge;
+  int64_t charged_energy;
+  int64_t discharged_energy;
+  int64_t charged_charge_today;
+  int64_t discharged_charge_today;
+  int64_t charged_energy_today;
+  int64_t discharged_energy_today;
+  uint32_t day;  // Tagesnummer, zu der *_today gehört (0 = unbekannt)
+};
+
+class EnergyCounter {
+ public:
+  // Längere Lücken zwischen zwei Frames werden nicht überbrückt
+  void set_max_gap(uint32_t max_gap_ms) { max_gap_ms_ = max_gap_ms; }
+  // Neuer Messpunkt; integriert vom vorherigen Punkt bis hierher, je halbes Intervall mit dem
+  // alten und dem neuen Wert, sodass ein Vorzeichenwechsel korrekt auf Laden/Entladen verteilt wird
+  void add_sample(uint32_t now, float pack_voltage, float current);
+  void start_day(uint32_t day);
+  float get(EnergyField field) const;
+
+  EnergyState &state() { return state_; }
+
+ protected:
+  void accumulate_(int32_t voltage, int32_t current, uint32_t dt);
+
+  EnergyState state_{};
+  uint32_t max_gap_ms_{60000};
+  uint32_t last_time_{0};
+  int32_t last_voltage_{0};  // cV
+  int32_t last_current_{0};  // cA
+  bool has_last_{false};
+};
+
+struct PackStatistics {
+  PackStatistics() {
+    for (auto &windows : this->windows) {
+      for (int window = 0; window < STAT_WINDOW_COUNT; window++) {
+        windows[window].set_window(STAT_WINDOW_MS[window]);
+      }
+    }
+  }
+
+  RollingWindow windows[STAT_QUANTITY_COUNT][STAT_WINDOW_COUNT];
+  EnergyCounter energy;
+  CellAnalytics cells;
+};
+
+}  // namespace seplos_parser
+}  // namespace esphome
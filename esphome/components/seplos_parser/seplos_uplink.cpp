@@ -0,0 +1,159 @@
+#include "seplos_uplink.h"
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace seplos_parser {
+
+static size_t put_varint(uint8_t *out, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = uint8_t(value) | 0x80;
+    value >>= 7;
+  }
+  out[n++] = uint8_t(value);
+  return n;
+}
+
+static void put_le(std::string *out, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out->push_back(char(value >> (8 * i)));
+  }
+}
+
+void UplinkRing::configure(size_t buffer_size, int bms_count) {
+  size_t chunks = buffer_size / CHUNK_SIZE;
+  chunks = chunks < 2 ? 2 : chunks;
+  storage_.assign(chunks * CHUNK_SIZE, 0);
+  chunks_.assign(chunks, Chunk{});
+  previous_.assign(size_t(bms_count) * BLOCK_COUNT * UPLINK_MAX_WORDS, 0);
+  clear();
+}
+
+void UplinkRing::clear() {
+  head_ = 0;
+  count_ = 0;
+  dropped_ = 0;
+}
+
+size_t UplinkRing::buffered_bytes() const {
+  size_t bytes = 0;
+  for (size_t i = 0; i < count_; i++) {
+    bytes += chunks_[(head_ + i) % chunks_.size()].length;
+  }
+  return bytes;
+}
+
+void UplinkRing::start_chunk_(uint32_t now) {
+  if (count_ == chunks_.size()) {
+    head_ = (head_ + 1) % chunks_.size();  // ältesten Abschnitt verwerfen
+    count_--;
+    dropped_++;
+  }
+  Chunk &chunk = chunks_[(head_ + count_) % chunks_.size()];
+  chunk.base_time = now;
+  chunk.last_time = now;
+  chunk.length = 0;
+  count_++;
+  std::fill(previous_.begin(), previous_.end(), 0);
+}
+
+void UplinkRing::add(uint32_t now, int bms_index, BlockId block, const uint8_t *payload, size_t length) {
+  int words = int(length / 2);
+  if (words > UPLINK_MAX_WORDS || size_t(bms_index + 1) * BLOCK_COUNT * UPLINK_MAX_WORDS > previous_.size()) {
+    return;
+  }
+  // Ungünstigster Eintrag: Kopfbyte, Zeit, Maske und je Wort 3 Byte
+  uint8_t record[1 + 5 + 5 + UPLINK_MAX_WORDS * 3];
+  bool fresh = false;
+  if (count_ == 0) {
+    start_chunk_(now);
+    fresh = true;
+  }
+  while (true) {
+    Chunk &chunk = chunks_[(head_ + count_ - 1) % chunks_.size()];
+    uint16_t *previous = previous_.data() + (size_t(bms_index) * BLOCK_COUNT + block) * UPLINK_MAX_WORDS;
+    uint16_t current[UPLINK_MAX_WORDS];
+    uint32_t mask = 0;
+    for (int i = 0; i < words; i++) {
+      current[i] = uint16_t(payload[2 * i] << 8 | payload[2 * i + 1]);
+      if (current[i] != previous[i]) {
+        mask |= 1u << i;
+      }
+    }
+    size_t n = 0;
+    record[n++] = uint8_t(bms_index & 0x0F) | uint8_t(block << 4) | uint8_t((bms_index >> 4) << 6);
+    n += put_varint(record + n, now - chunk.last_time);
+    n += put_varint(record + n, mask);
+    for (int i = 0; i < words; i++) {
+      if (mask & (1u << i)) {
+        int16_t delta = int16_t(uint16_t(current[i] - previous[i]));
+        n += put_varint(record + n, uint16_t(uint16_t(delta) << 1) ^ uint16_t(delta >> 15));
+      }
+    }
+    if (chunk.length + n <= CHUNK_SIZE) {
+      memcpy(chunk_data_((head_ + count_ - 1) % chunks_.size()) + chunk.length, record, n);
+      chunk.length += n;
+      chunk.last_time = now;
+      memcpy(previous, current, words * sizeof(uint16_t));
+      return;
+    }
+    if (fresh) {
+      return;  // passt nicht einmal in einen leeren Abschnitt
+    }
+    // Abschnitt voll: neu beginnen, der Eintrag wird dort vollständig (gegen 0) kodiert
+    start_chunk_(now);
+    fresh = true;
+  }
+}
+
+void write_uplink_header(std::string *out, int bms_count, const uint8_t *mac, uint32_t now, uint32_t unix_time,
+                         size_t chunks, uint32_t dropped_chunks) {
+  out->append("SPL1", 4);
+  out->push_back(char(UPLINK_FORMAT_VERSION));
+  out->push_back(char(bms_count));
+  out->append(reinterpret_cast<const char *>(mac), 6);
+  put_le(out, now, 4);
+  put_le(out, unix_time, 4);
+  put_le(out, chunks, 2);
+  put_le(out, dropped_chunks > 0xFFFF ? 0xFFFF : dropped_chunks, 2);
+}
+
+void UplinkRing::write_chunk(size_t index, std::string *out) const {
+  index = (head_ + index) % chunks_.size();
+  const Chunk &chunk = chunks_[index];
+  put_le(out, chunk.base_time, 4);
+  put_le(out, chunk.length, 2);
+  out->append(reinterpret_cast<const char *>(storage_.data() + index * CHUNK_SIZE), chunk.length);
+}
+
+size_t UplinkRing::write_payload(std::string *out, size_t max_size, int bms_count, const uint8_t *mac, uint32_t now,
+                                 uint32_t unix_time) const {
+  size_t chunks = 0;
+  size_t size = 0;
+  while (chunks < count_) {
+    size_t chunk_size = UPLINK_CHUNK_HEADER_SIZE + chunks_[(head_ + chunks) % chunks_.size()].length;
+    if (chunks > 0 && size + chunk_size > max_size) {
+      break;
+    }
+    size += chunk_size;
+    chunks++;
+  }
+  out->clear();
+  out->reserve(UPLINK_HEADER_SIZE + size);
+  write_uplink_header(out, bms_count, mac, now, unix_time, chunks, dropped_);
+  for (size_t i = 0; i < chunks; i++) {
+    write_chunk(i, out);
+  }
+  return chunks;
+}
+
+void UplinkRing::consume(size_t chunks) {
+  chunks = std::min(chunks, count_);
+  head_ = (head_ + chunks) % chunks_.size();
+  count_ -= chunks;  // bei 0 beginnt add() einen neuen Abschnitt mit zurückgesetzten Vorgängerwerten
+  dropped_ = 0;
+}
+
+}  // namespace seplos_parser
+}  // namespace esphome
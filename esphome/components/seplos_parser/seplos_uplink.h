@@ -0,0 +1,98 @@
+#pragma once
+
+// Ringpuffer für die gebündelte Übertragung der Rohregister an einen Webserver. Reines C++ wie seplos_frame.h;
+// das Senden selbst übernimmt SeplosParser über http_request.
+//
+// Nutzdaten eines POST (Content-Type application/octet-stream), alle Mehrbyte-Werte Little Endian:
+//
+//   Kopf, 24 Byte
+//     0   4  Kennung "SPL1"
+//     4   1  Formatversion (2; Version 1 kennt nur BMS-Index 0-15 und ist sonst gleich)
+//     5   1  bms_count
+//     6   6  MAC-Adresse
+//     12  4  millis() beim Senden (aus dem Flash-Journal: beim Schreiben ins Journal)
+//     16  4  Unix-Zeit zum selben Zeitpunkt in s, 0 = unbekannt
+//     20  2  Anzahl Abschnitte
+//     22  2  seit dem letzten erfolgreichen POST verworfene Abschnitte (Puffer voll)
+//   Abschnitte, ältester zuerst
+//     0   4  millis() des ersten Eintrags
+//     4   2  Länge L der Einträge in Byte
+//     6   L  Einträge
+//   Eintrag
+//     1 Byte  BMS-Index Bits 0-3 (Bits 0-3) | BlockId (Bits 4-5) | BMS-Index Bits 4-5 (Bits 6-7, ab Version 2)
+//     varint  ms seit dem vorherigen Eintrag des Abschnitts (beim ersten seit dem Abschnittsbeginn)
+//     varint  Änderungsmaske, Bit i = Wort i weicht vom vorherigen Eintrag desselben BMS und Blocks ab
+//     je gesetztem Bit: zigzag-varint der Differenz (int16, modulo 2^16)
+//
+// Worte sind die Datenbytes der Antwort als 16-Bit-Werte (Big Endian im Frame): 0x24 → 18, 0x34 → 26, 0x12 → 9.
+// Zu Beginn jedes Abschnitts gelten alle Vorgängerwerte als 0; jeder Abschnitt ist damit für sich dekodierbar und
+// bei vollem Puffer kann der älteste ohne Folgen für die übrigen verworfen werden. Referenzdekoder:
+// tools/seplos_uplink.py
+
+#include "seplos_registers.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace seplos_parser {
+
+static const uint8_t UPLINK_FORMAT_VERSION = 2;
+static const size_t UPLINK_HEADER_SIZE = 24;
+static const size_t UPLINK_CHUNK_HEADER_SIZE = 6;
+// Längster Block (0x34) in Worten
+static const int UPLINK_MAX_WORDS = 26;
+// Höchstens so viele Byte Abschnitte je POST; größere Puffer werden in mehreren POSTs gesendet, damit der
+// Body neben dem Puffer nicht noch einmal dessen volle Größe belegt
+static const size_t UPLINK_POST_SIZE = 16384;
+
+// Kopf der Nutzdaten; now und unix_time beschreiben denselben Zeitpunkt
+void write_uplink_header(std::string *out, int bms_count, const uint8_t *mac, uint32_t now, uint32_t unix_time,
+                         size_t chunks, uint32_t dropped_chunks);
+
+class UplinkRing {
+ public:
+  static const size_t CHUNK_SIZE = 1024;
+
+  // Puffergröße wird auf ganze Abschnitte abgerundet, mindestens zwei
+  void configure(size_t buffer_size, int bms_count);
+  // Datenbytes einer vollständigen Blockantwort (ohne Adresse, Funktion, Länge und CRC)
+  void add(uint32_t now, int bms_index, BlockId block, const uint8_t *payload, size_t length);
+  // Kopf und die ältesten Abschnitte, soweit sie in max_size Byte passen (mindestens einen), in out schreiben;
+  // gibt die Zahl der Abschnitte zurück. Der Puffer bleibt bis consume() oder clear() unverändert
+  size_t write_payload(std::string *out, size_t max_size, int bms_count, const uint8_t *mac, uint32_t now,
+                       uint32_t unix_time) const;
+  // Die ältesten Abschnitte nach erfolgreichem Senden freigeben; setzt auch den Zähler verworfener Abschnitte zurück
+  void consume(size_t chunks);
+  void clear();
+  // Abschnitt i (0 = ältester) im Übertragungsformat an out anhängen
+  void write_chunk(size_t index, std::string *out) const;
+
+  size_t chunk_count() const { return count_; }
+
+  bool empty() const { return count_ == 0; }
+  size_t buffered_bytes() const;
+  uint32_t dropped_chunks() const { return dropped_; }
+
+ protected:
+  struct Chunk {
+    uint32_t base_time;
+    uint32_t last_time;
+    uint16_t length;
+  };
+
+  uint8_t *chunk_data_(size_t chunk) { return storage_.data() + chunk * CHUNK_SIZE; }
+  void start_chunk_(uint32_t now);
+
+  std::vector<uint8_t> storage_;
+  std::vector<Chunk> chunks_;
+  size_t head_{0};   // ältester Abschnitt
+  size_t count_{0};  // belegte Abschnitte, der letzte wird beschrieben
+  uint32_t dropped_{0};
+  // Zuletzt geschriebene Worte je [BMS][Block] im aktuellen Abschnitt
+  std::vector<uint16_t> previous_;
+};
+
+}  // namespace seplos_parser
+}  // namespace esphome
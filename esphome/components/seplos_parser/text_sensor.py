@@ -1,19 +1,56 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import text_sensor
-from . import HUB_CHILD_SCHEMA, CONF_SEPLOS_PARSER_ID
+from . import (
+    HUB_CHILD_SCHEMA,
+    CONF_SEPLOS_PARSER_ID,
+    CONF_BMS_INDEX,
+    CONF_FIELD,
+    CONF_PACKED,
+    TEXT_SENSOR_FIELDS,
+    PACKED_BLOCKS,
+    field_keys_schema,
+    final_validate_bms_index,
+    resolve_field_keys,
+)
 
 DEPENDENCIES = ["seplos_parser"]
 
+
+def resolve_text_sensor_keys(config):
+    # Gepackte Sensoren tragen einen ganzen Block und brauchen nur den Pack
+    if CONF_PACKED in config:
+        if CONF_FIELD in config:
+            raise cv.Invalid(f"'{CONF_PACKED}' schließt '{CONF_FIELD}' aus")
+        if CONF_BMS_INDEX not in config:
+            raise cv.Invalid(f"'{CONF_PACKED}' braucht '{CONF_BMS_INDEX}'")
+        return config
+    return resolve_field_keys(TEXT_SENSOR_FIELDS)(config)
+
+
 CONFIG_SCHEMA = (
     text_sensor.text_sensor_schema()
     .extend(HUB_CHILD_SCHEMA)
+    .extend(field_keys_schema(TEXT_SENSOR_FIELDS))
+    .extend(
+        {
+            # pia (0x24) / pib (0x34): Werte durch Komma getrennt, pic (0x12): Alarm-Bytes als Hex
+            cv.Optional(CONF_PACKED): cv.one_of(*PACKED_BLOCKS, lower=True),
+        }
+    )
     .extend(cv.COMPONENT_SCHEMA)
+    .add_extra(resolve_text_sensor_keys)
 )
 
 
+FINAL_VALIDATE_SCHEMA = final_validate_bms_index
+
+
 async def to_code(config):
     paren = await cg.get_variable(config[CONF_SEPLOS_PARSER_ID])
     var = await text_sensor.new_text_sensor(config)
 
-    cg.add(paren.register_text_sensor(var))
+    if CONF_PACKED in config:
+        cg.add(paren.register_packed_sensor(config[CONF_BMS_INDEX], PACKED_BLOCKS[config[CONF_PACKED]], var))
+    else:
+        cg.add(paren.register_text_sensor(config[CONF_BMS_INDEX], TEXT_SENSOR_FIELDS[config[CONF_FIELD]], var))
@@ -0,0 +1,106 @@
+// Wendet die Zellanalyse von seplos_parser (seplos_cells.h) auf aufgezeichnete Frames an, mit demselben Code wie
+// auf dem ESP32. Eingabe: eine Zeile je Frame "<ms> <bms> <pia|pib|pic> <Datenbytes hex>", wie sie
+// tools/seplos_uplink.py frames aus einem Upload oder einer Ereignisaufzeichnung erzeugt.
+//
+//   cmake -S tools -B build && cmake --build build
+//   python3 tools/seplos_uplink.py frames capture.json | ./build/seplos_cells_replay [Ausgabeabstand in s, Standard 300]
+//
+// Für den Innenwiderstand muss die Aufzeichnung jeden Frame enthalten (capture: oder uplink: sample_interval: 0).
+// Ausgabe: JSON-Zeilen je BMS im Ausgabeabstand und am Ende mit den Werten je Zelle.
+
+#include "seplos_cells.h"
+#include "seplos_registers.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace esphome::seplos_parser;
+
+#define SEPLOS_CELL_FIELD_NAME(key, name) #name,
+static const char *const FIELD_NAMES[] = {SEPLOS_CELL_FIELDS(SEPLOS_CELL_FIELD_NAME)};
+static const char *const PER_CELL_NAMES[] = {SEPLOS_PER_CELL_FIELDS(SEPLOS_CELL_FIELD_NAME)};
+#undef SEPLOS_CELL_FIELD_NAME
+static const int PACK_FIELD_COUNT = sizeof(FIELD_NAMES) / sizeof(FIELD_NAMES[0]);
+
+static void print_value(float value) {
+  if (std::isnan(value)) {
+    printf("null");
+  } else {
+    printf("%.4g", value);
+  }
+}
+
+static void print_pack(uint32_t ms, int bms, const CellAnalytics &cells, bool per_cell) {
+  printf("{\"ms\":%u,\"bms\":%d", ms, bms);
+  for (int field = 0; field < PACK_FIELD_COUNT; field++) {
+    printf(",\"%s\":", FIELD_NAMES[field]);
+    print_value(cells.get(static_cast<CellField>(field)));
+  }
+  if (per_cell) {
+    for (int field = 0; field < 2; field++) {
+      printf(",\"%s\":[", PER_CELL_NAMES[field]);
+      for (int cell = 0; cell < CellAnalytics::MAX_CELLS; cell++) {
+        printf(cell > 0 ? "," : "");
+        print_value(cells.get(static_cast<CellField>(PACK_FIELD_COUNT + field), cell));
+      }
+      printf("]");
+    }
+  }
+  printf("}\n");
+}
+
+int main(int argc, char **argv) {
+  uint32_t interval = (argc > 1 ? strtoul(argv[1], nullptr, 10) : 300) * 1000;
+  CellAnalytics packs[MAX_BMS_COUNT];
+  bool seen[MAX_BMS_COUNT]{};
+  uint32_t next_output[MAX_BMS_COUNT]{};
+  uint32_t last_ms = 0;
+
+  char line[512];
+  while (fgets(line, sizeof(line), stdin) != nullptr) {
+    unsigned ms;
+    int bms;
+    char block[8], hex[256];
+    if (sscanf(line, "%u %d %7s %255s", &ms, &bms, block, hex) != 4 || bms < 0 || bms >= MAX_BMS_COUNT) {
+      continue;
+    }
+    // Frame wie vom Bus: Adresse, Funktion, Länge, Daten
+    uint8_t frame[3 + 64]{};
+    size_t length = strlen(hex) / 2;
+    for (size_t i = 0; i < length && i < 64; i++) {
+      char byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+      frame[3 + i] = uint8_t(strtoul(byte, nullptr, 16));
+    }
+    CellAnalytics &cells = packs[bms];
+    if (strcmp(block, "pia") == 0) {
+      for (const FieldDescriptor &desc : PIA_FIELDS) {
+        if (desc.field == SENSOR_CURRENT) {
+          cells.add_current(ms, decode_field(desc, frame));
+        }
+      }
+    } else if (strcmp(block, "pib") == 0) {
+      float voltages[CellAnalytics::MAX_CELLS];
+      for (int i = 0; i < CellAnalytics::MAX_CELLS; i++) {
+        voltages[i] = decode_field(PIB_FIELDS[i], frame);
+      }
+      cells.add_cells(ms, voltages, CellAnalytics::MAX_CELLS);
+    } else if (strcmp(block, "pic") == 0) {
+      cells.set_balancing(frame[9] | frame[10] << 8);
+    }
+    if (!seen[bms]) {
+      seen[bms] = true;
+      next_output[bms] = ms + interval;
+    } else if (int32_t(ms - next_output[bms]) >= 0) {
+      print_pack(ms, bms, cells, false);
+      next_output[bms] = ms + interval;
+    }
+    last_ms = ms;
+  }
+  for (int bms = 0; bms < MAX_BMS_COUNT; bms++) {
+    if (seen[bms]) {
+      print_pack(last_ms, bms, packs[bms], true);
+    }
+  }
+  return 0;
+}
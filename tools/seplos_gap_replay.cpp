@@ -0,0 +1,215 @@
+// Spielt eine Zeitspur des RS-485-Busses durch den Framing-Kern von seplos_parser (seplos_frame.h), mit derselben
+// Pausenerkennung wie drain_bus_(): loop() läuft in festem Abstand, liest alles, was available() meldet, und meldet
+// eine Pause, wenn seit dem letzten Lesevorgang mit neuen Bytes mindestens t3.5 vergangen sind.
+//
+//   cmake -S tools -B build && cmake --build build
+//   ./build/seplos_gap_replay tools/captures/gap_19200_bytewise.trace [loop()-Abstand µs 500] [header|gap]
+//   ./build/seplos_gap_replay --generate spur.trace [Baud 19200] [Packs 4] [Zyklen 5] [Schwelle 0]
+//
+// Eine Zeile der Spur ist eine Übergabe des UART-Treibers: "<µs> <Bytes hex>", ab diesem Zeitpunkt meldet available()
+// die Bytes. "# frames <n>" gibt die Zahl der Antworten in der Spur an.
+// --generate simuliert Master und Slaves (8N1); Schwelle 0 übergibt jedes Byte einzeln, sonst wie der ESP32-Treiber
+// schubweise, sobald so viele Bytes im FIFO liegen oder zwei Zeichen lang nichts mehr kam. Liegen zwischen zwei
+// Schüben mehr als t3.5, sieht loop() dort eine Pause mitten im Frame.
+// Ausgabe: gefundene Antworten, Pausen-/Rückfall-Statistik, Rechenzeit je Frame. Exit-Code 1, wenn Antworten fehlen.
+
+#include "seplos_frame.h"
+#include "seplos_registers.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace esphome::seplos_parser;
+
+struct Delivery {
+  uint32_t time;
+  std::vector<uint8_t> bytes;
+};
+
+static bool read_trace(const char *path, std::vector<Delivery> *trace, uint32_t *expected, uint32_t *baud) {
+  FILE *file = fopen(path, "r");
+  if (file == nullptr) {
+    return false;
+  }
+  char line[4096];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    if (line[0] == '#') {
+      sscanf(line, "# frames %u", expected);
+      sscanf(line, "# baud %u", baud);
+      continue;
+    }
+    char *pos;
+    Delivery delivery;
+    delivery.time = strtoul(line, &pos, 10);
+    unsigned byte;
+    int consumed;
+    while (sscanf(pos, " %2x%n", &byte, &consumed) == 1) {
+      delivery.bytes.push_back(uint8_t(byte));
+      pos += consumed;
+    }
+    if (!delivery.bytes.empty()) {
+      trace->push_back(delivery);
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+static int generate(const char *path, uint32_t baud, int packs, int cycles, size_t threshold) {
+  const double char_us = 10e6 / baud;
+  std::vector<std::pair<double, uint8_t>> bytes;  // Empfangszeit (Ende des Stoppbits) und Wert
+  double now = 10000;
+  uint32_t frames = 0;
+  uint32_t seed = 1;
+  auto append = [&](const std::vector<uint8_t> &frame) {
+    for (uint8_t byte : frame) {
+      now += char_us;
+      bytes.push_back({now, byte});
+    }
+  };
+  for (int cycle = 0; cycle < cycles; cycle++) {
+    for (int bms = 0; bms < packs; bms++) {
+      for (const BlockDescriptor &block : BLOCKS) {
+        std::vector<uint8_t> request = {uint8_t(bms + 1), block.function, uint8_t(block.start >> 8),
+                                        uint8_t(block.start & 0xFF), uint8_t(block.count >> 8),
+                                        uint8_t(block.count & 0xFF)};
+        uint16_t crc = calculate_modbus_crc(request.data(), request.size());
+        request.push_back(crc & 0xFF);
+        request.push_back(crc >> 8);
+        append(request);
+        now += 5000;  // Antwortzeit des Slaves
+
+        uint8_t byte_count = expected_byte_count(block.function, block.count);
+        std::vector<uint8_t> response = {uint8_t(bms + 1), block.function, byte_count};
+        for (int i = 0; i < byte_count; i++) {
+          seed = seed * 1103515245 + 12345;
+          response.push_back(uint8_t(seed >> 16));
+        }
+        crc = calculate_modbus_crc(response.data(), response.size());
+        response.push_back(crc & 0xFF);
+        response.push_back(crc >> 8);
+        append(response);
+        frames++;
+        now += 20000;  // Pause des Masters vor der nächsten Anfrage
+      }
+    }
+  }
+
+  FILE *file = fopen(path, "w");
+  if (file == nullptr) {
+    fprintf(stderr, "%s nicht schreibbar\n", path);
+    return 1;
+  }
+  fprintf(file, "# baud %u\n# frames %u\n# Schwelle %zu\n", baud, frames, threshold);
+  // Treiber: Übergabe bei voller Schwelle oder zwei Zeichen nach dem letzten Byte
+  std::vector<uint8_t> fifo;
+  for (size_t i = 0; i < bytes.size(); i++) {
+    fifo.push_back(bytes[i].second);
+    double time = bytes[i].first;
+    bool timeout = i + 1 == bytes.size() || bytes[i + 1].first - time > 2 * char_us;
+    if (threshold == 0 || fifo.size() >= threshold || timeout) {
+      if (threshold != 0 && timeout && fifo.size() < threshold) {
+        time += 2 * char_us;
+      }
+      fprintf(file, "%u", uint32_t(time));
+      for (uint8_t byte : fifo) {
+        fprintf(file, " %02X", byte);
+      }
+      fprintf(file, "\n");
+      fifo.clear();
+    }
+  }
+  fclose(file);
+  printf("%zu Byte, %u Antworten nach %s geschrieben\n", bytes.size(), frames, path);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 2 && strcmp(argv[1], "--generate") == 0) {
+    uint32_t baud = argc > 3 ? strtoul(argv[3], nullptr, 10) : 19200;
+    int packs = argc > 4 ? atoi(argv[4]) : 4;
+    int cycles = argc > 5 ? atoi(argv[5]) : 5;
+    size_t threshold = argc > 6 ? strtoul(argv[6], nullptr, 10) : 0;
+    if (baud < 1200 || packs < 1 || packs > MAX_BUS_ADDRESSES || cycles < 1) {
+      fprintf(stderr, "Baud ab 1200, Packs 1-%d, mindestens ein Zyklus\n", MAX_BUS_ADDRESSES);
+      return 1;
+    }
+    return generate(argv[2], baud, packs, cycles, threshold);
+  }
+  if (argc < 2) {
+    fprintf(stderr, "%s <Spur> [loop()-Abstand µs] [header|gap]\n", argv[0]);
+    return 1;
+  }
+  std::vector<Delivery> trace;
+  uint32_t expected = 0;
+  uint32_t baud = 19200;
+  if (!read_trace(argv[1], &trace, &expected, &baud) || trace.empty()) {
+    fprintf(stderr, "%s nicht lesbar oder leer\n", argv[1]);
+    return 1;
+  }
+  uint32_t loop_us = argc > 2 ? strtoul(argv[2], nullptr, 10) : 500;
+  bool gap_framing = argc <= 3 || strcmp(argv[3], "header") != 0;
+  if (loop_us < 1) {
+    fprintf(stderr, "loop()-Abstand mindestens 1 µs\n");
+    return 1;
+  }
+  // Wie SeplosParser::setup()
+  uint32_t frame_gap_us = baud > 19200 ? 1750 : 38500000UL / baud;
+
+  FrameScanner scanner;
+  scanner.set_gap_framing(gap_framing);
+  std::vector<uint8_t> uart;  // Empfangspuffer des Treibers
+  size_t next = 0;
+  uint32_t last_rx_us = 0;
+  uint32_t responses = 0;
+  std::chrono::duration<double> busy{0};
+  uint32_t end = trace.back().time + 10 * frame_gap_us + loop_us;
+  for (uint32_t now = loop_us; now <= end; now += loop_us) {
+    while (next < trace.size() && trace[next].time <= now) {
+      uart.insert(uart.end(), trace[next].bytes.begin(), trace[next].bytes.end());
+      next++;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    // drain_bus_()
+    if (gap_framing) {
+      if (!uart.empty()) {
+        last_rx_us = now;
+      } else if (scanner.pending() > 0 && now - last_rx_us >= frame_gap_us) {
+        scanner.mark_gap();
+      }
+    }
+    size_t offset = 0;
+    do {
+      size_t space;
+      uint8_t *dest = scanner.prepare_write(&space);
+      size_t chunk = std::min(uart.size() - offset, space);
+      memcpy(dest, uart.data() + offset, chunk);
+      scanner.commit_write(chunk);
+      offset += chunk;
+      ModbusFrame frame;
+      while (scanner.next_frame(&frame)) {
+        if (frame.kind == FRAME_RESPONSE && frame.paired) {
+          responses++;
+        }
+      }
+    } while (offset < uart.size());
+    uart.clear();
+    busy += std::chrono::steady_clock::now() - begin;
+  }
+
+  const FrameScannerStats &stats = scanner.get_stats();
+  printf("%s, %u Baud, t3.5 %u µs, loop() alle %u µs\n", gap_framing ? "Pausen-Framing" : "Header-Suche", baud,
+         frame_gap_us, loop_us);
+  printf("Antworten %u von %u, Frames %u, CRC-Fehler %u, Resync %u Byte\n", responses, expected, stats.frames,
+         stats.crc_errors, stats.resync_bytes);
+  if (gap_framing) {
+    printf("Frames per Pause %u, per Header-Suche zerlegte Abschnitte %u, über eine Pause reichende Frames %u\n",
+           stats.gap_frames, stats.gap_fallbacks, stats.gap_splits);
+  }
+  printf("%.0f ns/Frame\n", stats.frames > 0 ? busy.count() * 1e9 / stats.frames : 0.0);
+  return responses == expected ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+// Betreibt das Upload-Journal von seplos_parser (seplos_journal.h) auf einem RAM-Abbild eines NOR-Flash, mit demselben
+// Code wie auf dem ESP32. Das Abbild verhält sich wie der Flash: write() kann nur Bits von 1 auf 0 setzen, gelöscht
+// wird sektorweise, und ein Stromausfall bricht einen Schreibvorgang nach einer beliebigen Byteanzahl ab.
+//
+//   cmake -S tools -B build && cmake --build build
+//   ./build/seplos_journal_sim [Größe KiB 256] [Abschnitte 6000]
+//   ./build/seplos_journal_sim --torn
+//
+// Standard: Abschnitte von 200-1100 Byte anhängen, dazwischen zufällig Stapel abholen (nicht während simulierter
+// Verbindungsausfälle) und neu starten. Jeder Stapel wird mit dem Geschriebenen verglichen. Ausgabe:
+// Schreibverstärkung, Löschvorgänge je Sektor, Einträge je Löschvorgang, gelesene Bytes je abgeholtem Byte.
+// --torn: Stromausfall nach jeder möglichen Byteanzahl eines festen Ablaufs, danach Neustart; die wiederhergestellten
+// Einträge müssen genau die zuletzt vollständig geschriebenen sein, ein abgebrochener Eintrag taucht nie auf.
+// Exit-Code 1 bei jeder Abweichung.
+
+#include "seplos_journal.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace esphome::seplos_parser;
+
+class RamJournalStorage : public JournalStorage {
+ public:
+  explicit RamJournalStorage(size_t size) : data_(size, 0xFF), erases_(size / SECTOR_SIZE, 0) {}
+
+  size_t size() const override { return data_.size(); }
+  bool read(size_t offset, void *data, size_t length) override {
+    if (offset + length > data_.size()) {
+      return false;
+    }
+    memcpy(data, data_.data() + offset, length);
+    bytes_read_ += length;
+    return true;
+  }
+  bool write(size_t offset, const void *data, size_t length) override {
+    if (offset + length > data_.size() || power_lost_) {
+      return false;
+    }
+    size_t n = std::min(length, power_budget_);
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < n; i++) {
+      data_[offset + i] &= bytes[i];
+    }
+    bytes_programmed_ += n;
+    power_budget_ -= n;
+    if (n < length) {
+      power_lost_ = true;
+      return false;
+    }
+    return true;
+  }
+  bool erase_sector(size_t offset) override {
+    if (offset % SECTOR_SIZE != 0 || offset >= data_.size() || power_lost_) {
+      return false;
+    }
+    if (power_budget_ == 0) {
+      power_lost_ = true;
+      return false;
+    }
+    std::fill(data_.begin() + offset, data_.begin() + offset + SECTOR_SIZE, 0xFF);
+    erases_[offset / SECTOR_SIZE]++;
+    return true;
+  }
+
+  // Nach so vielen programmierten Bytes fällt der Strom aus; danach schlägt jeder Zugriff fehl
+  void cut_power_after(size_t bytes) { power_budget_ = bytes; }
+  // Neustart: der Flash-Inhalt bleibt, Zugriffe gehen wieder
+  void restore_power() {
+    power_lost_ = false;
+    power_budget_ = SIZE_MAX;
+  }
+  bool power_lost() const { return power_lost_; }
+  uint64_t bytes_read() const { return bytes_read_; }
+  uint64_t bytes_programmed() const { return bytes_programmed_; }
+  const std::vector<uint32_t> &erases() const { return erases_; }
+
+ protected:
+  std::vector<uint8_t> data_;
+  std::vector<uint32_t> erases_;
+  size_t power_budget_{SIZE_MAX};
+  bool power_lost_{false};
+  uint64_t bytes_read_{0};
+  uint64_t bytes_programmed_{0};
+};
+
+static std::string random_chunk(std::mt19937 &random, size_t length) {
+  std::string chunk(length, '\0');
+  for (char &c : chunk) {
+    c = char(random());
+  }
+  return chunk;
+}
+
+// Stapel gegen die ältesten erwarteten Einträge prüfen und sie entfernen
+static bool check_batch(const JournalBatch &batch, std::deque<std::string> *expected) {
+  std::string data;
+  for (size_t i = 0; i < batch.records; i++) {
+    if (expected->empty()) {
+      return false;
+    }
+    data += expected->front();
+    expected->pop_front();
+  }
+  return data == batch.data;
+}
+
+static int measure(size_t size, int chunks) {
+  std::mt19937 random(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  RamJournalStorage storage(size);
+  Journal journal;
+  if (!journal.begin(&storage)) {
+    fprintf(stderr, "Journal braucht mindestens zwei Sektoren\n");
+    return 1;
+  }
+  std::deque<std::string> expected;
+  JournalAnchor anchor{1000, 0};
+  uint64_t payload = 0, drained = 0, drain_reads = 0;
+  uint32_t written = 0, dropped = 0, reboots = 0, batches = 0;
+  bool online = true;
+  for (int n = 0; n < chunks; n++) {
+    if (uniform(random) < 0.05) {
+      anchor.millis += 300000;
+    }
+    std::string chunk = random_chunk(random, 200 + random() % 901);
+    uint32_t dropped_before = journal.get_stats().records_dropped;
+    if (!journal.append(anchor, reinterpret_cast<const uint8_t *>(chunk.data()), chunk.size())) {
+      fprintf(stderr, "Abschnitt %d: append() fehlgeschlagen\n", n);
+      return 1;
+    }
+    for (uint32_t i = dropped_before; i < journal.get_stats().records_dropped; i++) {
+      expected.pop_front();
+      dropped++;
+    }
+    expected.push_back(chunk);
+    payload += chunk.size();
+    written++;
+
+    // Längere Ausfälle der Verbindung füllen das Journal, bis der älteste Sektor überschrieben wird
+    if (uniform(random) < (online ? 0.005 : 0.002)) {
+      online = !online;
+    }
+    if (online && uniform(random) < 0.1) {
+      int count = 1 + random() % 4;
+      JournalBatch batch;
+      for (int i = 0; i < count; i++) {
+        uint64_t reads_before = storage.bytes_read();
+        if (!journal.read_batch(16384, &batch)) {
+          break;
+        }
+        drain_reads += storage.bytes_read() - reads_before;
+        if (!check_batch(batch, &expected)) {
+          fprintf(stderr, "Abschnitt %d: abgeholter Stapel weicht vom Geschriebenen ab\n", n);
+          return 1;
+        }
+        journal.consume(batch);
+        drained += batch.data.size();
+        batches++;
+      }
+    }
+    if (uniform(random) < 0.01) {
+      journal = Journal();
+      if (!journal.begin(&storage) || journal.pending_records() != expected.size()) {
+        fprintf(stderr, "Abschnitt %d: nach Neustart %u statt %zu offene Einträge\n", n, journal.pending_records(),
+                expected.size());
+        return 1;
+      }
+      anchor.millis = 1000;
+      reboots++;
+    }
+  }
+
+  const std::vector<uint32_t> &erases = storage.erases();
+  uint32_t total_erases = 0;
+  for (uint32_t count : erases) {
+    total_erases += count;
+  }
+  printf("%zu KiB, %u Abschnitte (%.0f KiB), %u Neustarts, %u Stapel abgeholt, %u überschrieben\n", size / 1024,
+         written, payload / 1024.0, reboots, batches, dropped);
+  printf("Schreibverstärkung %.3f (programmiert/Nutzdaten)\n", double(storage.bytes_programmed()) / payload);
+  printf("Löschvorgänge je Sektor %u-%u, %.1f Einträge je Löschvorgang\n",
+         *std::min_element(erases.begin(), erases.end()), *std::max_element(erases.begin(), erases.end()),
+         double(written) / total_erases);
+  printf("Abholen liest %.3f Byte je Nutzbyte\n", drained > 0 ? double(drain_reads) / drained : 0.0);
+  printf("Alle abgeholten Stapel stimmen mit dem Geschriebenen überein\n");
+  return 0;
+}
+
+// Fester Ablauf über den Sektorwechsel hinweg; Stromausfall nach cut programmierten Bytes. Liefert die bis dahin
+// vollständig angehängten Einträge und wie viele davon vor dem Ausfall sicher abgeholt waren.
+static void run_script(RamJournalStorage *storage, size_t cut, std::vector<std::string> *committed, size_t *consumed) {
+  std::mt19937 random(7);
+  Journal journal;
+  journal.begin(storage);
+  storage->cut_power_after(cut);
+  JournalAnchor anchor{1000, 0};
+  committed->clear();
+  *consumed = 0;
+  for (int n = 0; n < 30 && !storage->power_lost(); n++) {
+    std::string chunk = random_chunk(random, 100 + random() % 500);
+    if (journal.append(anchor, reinterpret_cast<const uint8_t *>(chunk.data()), chunk.size())) {
+      committed->push_back(chunk);
+    }
+    if (n == 9 && !storage->power_lost()) {
+      JournalBatch batch;
+      if (journal.read_batch(2048, &batch)) {
+        journal.consume(batch);
+        if (!storage->power_lost()) {
+          *consumed = batch.records;
+        }
+      }
+    }
+  }
+}
+
+static int torn() {
+  // Länge des ungestörten Ablaufs in programmierten Bytes
+  RamJournalStorage reference(2 * JournalStorage::SECTOR_SIZE);
+  std::vector<std::string> committed;
+  size_t consumed;
+  run_script(&reference, SIZE_MAX, &committed, &consumed);
+  size_t total = reference.bytes_programmed();
+
+  uint32_t corrupt = 0;
+  for (size_t cut = 0; cut <= total; cut++) {
+    RamJournalStorage storage(2 * JournalStorage::SECTOR_SIZE);
+    run_script(&storage, cut, &committed, &consumed);
+    storage.restore_power();
+
+    // Zweimal starten, ohne abzuholen: ein beim ersten Start erkannter Rest darf beim zweiten nicht wieder zählen
+    Journal first;
+    if (!first.begin(&storage)) {
+      printf("Ausfall nach %zu Byte: begin() fehlgeschlagen\n", cut);
+      return 1;
+    }
+    corrupt += first.get_stats().corrupt_records;
+    Journal journal;
+    journal.begin(&storage);
+    if (journal.pending_records() != first.pending_records()) {
+      printf("Ausfall nach %zu Byte: zweiter Start findet %u statt %u offene Einträge\n", cut,
+             journal.pending_records(), first.pending_records());
+      return 1;
+    }
+
+    // Alles abholen; der Inhalt muss genau das Ende der vollständig geschriebenen Einträge sein
+    std::string all;
+    size_t count = 0;
+    JournalBatch batch;
+    while (journal.read_batch(SIZE_MAX, &batch)) {
+      all += batch.data;
+      count += batch.records;
+      journal.consume(batch);
+    }
+    std::string tail;
+    size_t start = committed.size();
+    while (start > 0 && tail.size() < all.size()) {
+      start--;
+      tail = committed[start] + tail;
+    }
+    if (tail != all || count != committed.size() - start) {
+      printf("Ausfall nach %zu Byte: wiederhergestellte Einträge sind nicht das Ende der geschriebenen\n", cut);
+      return 1;
+    }
+    if (count > 0 && start < consumed) {
+      printf("Ausfall nach %zu Byte: bereits abgeholte Einträge tauchen wieder auf\n", cut);
+      return 1;
+    }
+    if (committed.size() > consumed && count == 0) {
+      printf("Ausfall nach %zu Byte: letzter vollständiger Eintrag fehlt\n", cut);
+      return 1;
+    }
+
+    // Nach der Wiederherstellung weiterschreiben; nach einem weiteren Neustart steht nur der neue Eintrag an
+    std::string next = "nach dem Neustart";
+    journal.append({2000, 0}, reinterpret_cast<const uint8_t *>(next.data()), next.size());
+    Journal after;
+    if (!after.begin(&storage) || after.pending_records() != 1 || !after.read_batch(SIZE_MAX, &batch) ||
+        batch.data != next) {
+      printf("Ausfall nach %zu Byte: Schreiben nach der Wiederherstellung fehlerhaft\n", cut);
+      return 1;
+    }
+  }
+  printf("Stromausfall nach 0-%zu programmierten Byte: alle %zu Fälle wiederhergestellt, %u abgebrochene Einträge "
+         "erkannt\n",
+         total, total + 1, corrupt);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "--torn") == 0) {
+    return torn();
+  }
+  size_t size = (argc > 1 ? strtoul(argv[1], nullptr, 10) : 256) * 1024;
+  int chunks = argc > 2 ? atoi(argv[2]) : 6000;
+  return measure(size, chunks);
+}
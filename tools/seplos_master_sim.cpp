@@ -0,0 +1,189 @@
+// Betreibt den Abfrageplaner von seplos_parser (seplos_master.h) gegen simulierte Seplos-Slaves, mit demselben
+// Code wie auf dem ESP32 und simulierter Zeit. Die Slaves antworten nach 20-60 ms, verlieren einen Teil der
+// Anfragen, fehlende Packs antworten nie. Pack 0 meldet bei 30 s zugleich mit einem Stromsprung einen Alarm
+// (bis 60 s), bei 125 s einen zweiten ohne Stromsprung (bis 155 s).
+//
+//   cmake -S tools -B build && cmake --build build
+//   ./build/seplos_master_sim [Packs 4] [Baud 19200] [Dauer s 300] [Verlustrate 0.02] [fehlende Packs 0] [Budget 0.5]
+//
+// Ausgabe: Abfragen je Pack und Block (Pack 0 fragt 0x12 während der Alarme im Sekundentakt ab), Busbelegung,
+// Zeitüberschreitungen und wie schnell die Alarme erkannt wurden. Exit-Code 1, wenn ein vorhandener Pack einen Block
+// nie geliefert hat.
+
+#include "seplos_frame.h"
+#include "seplos_master.h"
+#include "seplos_registers.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using namespace esphome::seplos_parser;
+
+static const uint32_t LOOP_US = 16000;  // Abstand der loop()-Aufrufe in ESPHome
+
+struct Scenario {
+  uint32_t step_at, alarm_from, alarm_to, alarm2_from, alarm2_to;
+};
+static const Scenario SCENARIO = {30000000, 30000000, 60000000, 125000000, 155000000};
+
+static bool alarm_on(uint32_t now) {
+  return (now >= SCENARIO.alarm_from && now < SCENARIO.alarm_to) ||
+         (now >= SCENARIO.alarm2_from && now < SCENARIO.alarm2_to);
+}
+
+static const AlarmDescriptor &sim_alarm() {
+  for (const AlarmDescriptor &desc : ALARM_DESCRIPTORS) {
+    if (desc.kind == ALARM_KIND_ALARM) {
+      return desc;
+    }
+  }
+  return ALARM_DESCRIPTORS[0];
+}
+
+static void encode(const FieldDescriptor &desc, uint8_t *frame, float value) {
+  int32_t raw = int32_t(lroundf((value - desc.add) * desc.divisor));
+  frame[desc.offset] = uint8_t(raw >> 8);
+  frame[desc.offset + 1] = uint8_t(raw);
+}
+
+// Antwort des Slaves auf eine Anfrage für den ganzen Block
+static size_t build_response(int bms, BlockId block, uint32_t now, uint8_t *frame) {
+  const BlockDescriptor &desc = BLOCKS[block];
+  uint8_t byte_count = expected_byte_count(desc.function, desc.count);
+  frame[0] = bms + 1;
+  frame[1] = desc.function;
+  frame[2] = byte_count;
+  memset(frame + RESPONSE_HEADER_SIZE, 0, byte_count);
+  if (block == BLOCK_PIA) {
+    for (int i = 0; i < desc.field_count; i++) {
+      if (desc.fields[i].field == SENSOR_CURRENT) {
+        encode(desc.fields[i], frame, bms == 0 && now >= SCENARIO.step_at ? -40.0f : 20.0f);
+      }
+    }
+  } else if (block == BLOCK_PIC && bms == 0 && alarm_on(now)) {
+    const AlarmDescriptor &alarm = sim_alarm();
+    frame[alarm.byte] |= alarm.mask;
+  }
+  size_t length = RESPONSE_HEADER_SIZE + byte_count;
+  uint16_t crc = calculate_modbus_crc(frame, length);
+  frame[length] = crc & 0xFF;
+  frame[length + 1] = crc >> 8;
+  return length + 2;
+}
+
+int main(int argc, char **argv) {
+  int packs = argc > 1 ? atoi(argv[1]) : 4;
+  uint32_t baud = argc > 2 ? strtoul(argv[2], nullptr, 10) : 19200;
+  uint32_t duration = (argc > 3 ? strtoul(argv[3], nullptr, 10) : 300) * 1000000UL;
+  double loss = argc > 4 ? atof(argv[4]) : 0.02;
+  int missing = argc > 5 ? atoi(argv[5]) : 0;
+  float budget = argc > 6 ? float(atof(argv[6])) : 0.5f;
+  if (packs < 1 || packs > MAX_BMS_COUNT || duration > 4000000000UL) {
+    fprintf(stderr, "Packs 1-%d, Dauer höchstens 4000 s\n", MAX_BMS_COUNT);
+    return 1;
+  }
+
+  std::mt19937 random(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  PollScheduler scheduler;
+  scheduler.set_bus_budget(budget);
+  scheduler.configure(packs, baud, 0);
+  FrameScanner scanner;
+
+  uint32_t polls[MAX_BMS_COUNT][BLOCK_COUNT]{};
+  uint8_t response[MAX_FRAME_LENGTH];
+  size_t response_length = 0;
+  uint32_t response_at = 0;  // Ende der Übertragung, 0 = keine Antwort unterwegs
+  uint32_t alarm_seen[2] = {0, 0};
+  float last_current = NAN;
+  bool alarm_was = false;
+
+  for (uint32_t now = LOOP_US; now < duration; now += LOOP_US) {
+    // drain_rx_(): angekommene Antwort in den Scanner, Frames an den Planer
+    if (response_at != 0 && int32_t(now - response_at) >= 0) {
+      size_t space;
+      uint8_t *dest = scanner.prepare_write(&space);
+      memcpy(dest, response, response_length);
+      scanner.commit_write(response_length);
+      response_at = 0;
+      ModbusFrame frame;
+      while (scanner.next_frame(&frame)) {
+        if (frame.kind == FRAME_REQUEST) {
+          continue;
+        }
+        scheduler.on_response(now, frame.data[0], frame.kind == FRAME_EXCEPTION);
+        const BlockDescriptor *block = find_block(frame.data[1], frame.start, frame.count);
+        int bms = frame.data[0] - 1;
+        if (block == nullptr || !frame.paired) {
+          continue;
+        }
+        polls[bms][block->id]++;
+        if (bms != 0) {
+          continue;
+        }
+        if (block->id == BLOCK_PIA) {
+          for (int i = 0; i < block->field_count; i++) {
+            if (block->fields[i].field != SENSOR_CURRENT) {
+              continue;
+            }
+            float current = decode_field(block->fields[i], frame.data);
+            if (!std::isnan(last_current) && fabsf(current - last_current) >= 10.0f) {
+              scheduler.request_soon(0, BLOCK_PIC);
+            }
+            last_current = current;
+          }
+        } else if (block->id == BLOCK_PIC) {
+          const AlarmDescriptor &alarm = sim_alarm();
+          bool active = (frame.data[alarm.byte] & alarm.mask) != 0;
+          scheduler.set_alarm_active(0, active);
+          if (active && !alarm_was) {
+            alarm_seen[now >= SCENARIO.alarm2_from ? 1 : 0] = now;
+          }
+          alarm_was = active;
+        }
+      }
+    }
+
+    // poll_master_()
+    PollRequest request;
+    if (!scheduler.next_request(now, &request)) {
+      continue;
+    }
+    const BlockDescriptor &block = BLOCKS[request.block];
+    scanner.expect_response(request.frame[0], block.function, block.start, block.count);
+    if (request.bms_index >= packs - missing || uniform(random) < loss) {
+      continue;  // keine Antwort
+    }
+    uint32_t latency = 20000 + uint32_t(uniform(random) * 40000);
+    response_length = build_response(request.bms_index, request.block, now, response);
+    response_at = now + scheduler.airtime(POLL_REQUEST_SIZE) + latency + scheduler.airtime(response_length);
+  }
+
+  const PollStats &stats = scheduler.get_stats();
+  double seconds = duration / 1e6;
+  printf("%d Packs (%d fehlend), %u Baud, %.0f s, Verlustrate %.1f %%, Budget %.0f %%\n", packs, missing, baud,
+         seconds, loss * 100.0, budget * 100.0f);
+  printf("Pack  0x24/s  0x34/s  0x12/s\n");
+  for (int bms = 0; bms < packs; bms++) {
+    printf("%4d  %6.2f  %6.2f  %6.2f\n", bms, polls[bms][BLOCK_PIA] / seconds, polls[bms][BLOCK_PIB] / seconds,
+           polls[bms][BLOCK_PIC] / seconds);
+  }
+  printf("Anfragen %u, Antworten %u, Zeitüberschreitungen %u, ausgefallen %u\n", stats.requests, stats.responses,
+         stats.timeouts, stats.failures);
+  printf("Busbelegung %.1f %%\n", 100.0 * stats.airtime_us / duration);
+  auto latency = [](uint32_t seen, uint32_t at) { return seen == 0 ? -1.0 : (seen - at) / 1e3; };
+  printf("Alarm mit Stromsprung erkannt nach %.0f ms, Alarm ohne Stromsprung nach %.0f ms\n",
+         latency(alarm_seen[0], SCENARIO.alarm_from), latency(alarm_seen[1], SCENARIO.alarm2_from));
+  // Auch mit dem kleinsten Budget muss jeder vorhandene Pack jeden Block liefern
+  for (int bms = 0; bms < packs - missing; bms++) {
+    for (int block = 0; block < BLOCK_COUNT; block++) {
+      if (polls[bms][block] == 0) {
+        printf("Pack %d: Block %d nie abgefragt\n", bms, block);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,290 @@
+// Spielt einen Mitschnitt des RS-485-Busses durch den Framing-Kern von seplos_parser (seplos_frame.h), mit demselben
+// Code wie auf dem ESP32. Der Mitschnitt ist der rohe Bytestrom, wie ihn z. B. "cat /dev/ttyUSB0 > bus.bin" bei
+// passender Baudrate aufzeichnet; er wird in Lesevorgängen fester Größe eingespeist, wie read_array() in loop().
+//
+//   cmake -S tools -B build && cmake --build build
+//   ./build/seplos_replay tools/captures/sample_16packs.bin [Lesegröße 64] [Wiederholungen 1] [scanner|deque]
+//   ./build/seplos_replay --generate bus.bin [Packs 16] [Zyklen 2000] [Störrate 0.1] [Scheinheader 0]
+//
+// --generate erzeugt einen synthetischen Mitschnitt: je Zyklus fragt der Master jeden Pack nach 0x24, 0x34 und 0x12,
+// ein Anteil der Antworten ist verfälscht oder abgeschnitten, dazwischen liegen vereinzelt Störbytes. Mit
+// Scheinheader > 0 steht vor diesem Anteil der Anfragen ein Störheader "<Adresse> 04 FF", der einen Frame von
+// 260 Byte ankündigt; der Scanner muss die echten Frames dahinter trotzdem sofort finden.
+// deque spielt zum Vergleich den früheren Empfangsweg nach: Fenster als std::deque<uint8_t> mit höchstens 100 Byte,
+// byteweises read(), CRC über eine Tabelle mit 256 Einträgen, loop() kehrt nach jedem gültigen Paket zurück.
+// In beiden Fällen kommen je loop()-Aufruf "Lesegröße" Byte im UART-Puffer an; bleibt am Ende etwas liegen, folgen
+// weitere Aufrufe ohne neue Bytes.
+// Ausgabe: Frames, CRC-Fehler und verworfene Bytes des Scanners, Verzögerung (wie viele Bytes hinter einem Frame
+// schon gelesen waren, als er geliefert wurde), Durchsatz, Zeit je loop() und Speicherbedarf.
+
+#include "seplos_frame.h"
+#include "seplos_registers.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+using namespace esphome::seplos_parser;
+
+static bool read_file(const char *path, std::vector<uint8_t> *out) {
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    out->insert(out->end(), chunk, chunk + n);
+  }
+  fclose(file);
+  return true;
+}
+
+static void append_crc(std::vector<uint8_t> *out, size_t start) {
+  uint16_t crc = calculate_modbus_crc(out->data() + start, out->size() - start);
+  out->push_back(crc & 0xFF);
+  out->push_back(crc >> 8);
+}
+
+// Empfangsweg vor dem FrameScanner (seplos_parser.cpp im Ausgangsstand), ohne Auswertung der Pakete
+class DequeBaseline {
+ public:
+  DequeBaseline() {
+    for (int i = 0; i < 256; i++) {
+      uint16_t crc = i;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = crc & 1 ? (crc >> 1) ^ 0xA001 : crc >> 1;
+      }
+      crc_table_[i] = crc;
+    }
+  }
+
+  void loop(std::deque<uint8_t> *uart) {
+    while (!uart->empty()) {
+      uint8_t byte = uart->front();  // read()
+      uart->pop_front();
+      buffer_.push_back(byte);
+      if (buffer_.size() > 100) {
+        buffer_.pop_front();
+      }
+      if (buffer_.size() >= 5) {
+        if (!is_valid_header_()) {
+          buffer_.pop_front();
+          continue;
+        }
+        size_t expected_length = get_expected_length_();
+        if (buffer_.size() >= expected_length) {
+          if (validate_crc_(expected_length)) {
+            process_packet_();
+            buffer_.erase(buffer_.begin(), buffer_.begin() + expected_length);
+            return;
+          }
+          crc_errors_++;
+          buffer_.pop_front();
+        }
+      }
+    }
+  }
+
+  uint32_t frames() const { return frames_; }
+  uint32_t crc_errors() const { return crc_errors_; }
+  const uint32_t *per_block() const { return per_block_; }
+
+ protected:
+  bool is_valid_header_() const {
+    return buffer_[0] >= 0x01 && buffer_[0] <= 0x10 &&
+           ((buffer_[1] == 0x04 && (buffer_[2] == 0x24 || buffer_[2] == 0x34)) ||
+            (buffer_[1] == 0x01 && buffer_[2] == 0x12));
+  }
+  size_t get_expected_length_() const {
+    if (buffer_[2] == 0x24) {
+      return 41;
+    }
+    if (buffer_[2] == 0x34) {
+      return 57;
+    }
+    return 23;
+  }
+  bool validate_crc_(size_t length) const {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length - 2; i++) {
+      crc = (crc >> 8) ^ crc_table_[(crc ^ buffer_[i]) & 0xFF];
+    }
+    return crc == ((buffer_[length - 1] << 8) | buffer_[length - 2]);
+  }
+  void process_packet_() {
+    frames_++;
+    per_block_[buffer_[2] == 0x24 ? BLOCK_PIA : buffer_[2] == 0x34 ? BLOCK_PIB : BLOCK_PIC]++;
+  }
+
+  std::deque<uint8_t> buffer_;
+  uint16_t crc_table_[256];
+  uint32_t frames_{0};
+  uint32_t crc_errors_{0};
+  uint32_t per_block_[BLOCK_COUNT]{};
+};
+
+static int replay_deque(const std::vector<uint8_t> &capture, size_t read_size, int repetitions) {
+  uint32_t frames = 0;
+  uint32_t crc_errors = 0;
+  uint32_t per_block[BLOCK_COUNT]{};
+  uint64_t loop_calls = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (int repetition = 0; repetition < repetitions; repetition++) {
+    DequeBaseline baseline;
+    std::deque<uint8_t> uart;
+    size_t pos = 0;
+    while (pos < capture.size() || !uart.empty()) {
+      size_t length = std::min(read_size, capture.size() - pos);
+      uart.insert(uart.end(), capture.begin() + pos, capture.begin() + pos + length);
+      pos += length;
+      baseline.loop(&uart);
+      loop_calls++;
+    }
+    frames = baseline.frames();
+    crc_errors = baseline.crc_errors();
+    memcpy(per_block, baseline.per_block(), sizeof(per_block));
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  printf("%zu Byte, Lesegröße %zu, %d Wiederholungen, deque + read()\n", capture.size(), read_size, repetitions);
+  printf("Frames %u, 0x24/0x34/0x12: %u/%u/%u, CRC-Fehler %u\n", frames, per_block[BLOCK_PIA], per_block[BLOCK_PIB],
+         per_block[BLOCK_PIC], crc_errors);
+  printf("%.1f MB/s, %.1f ns je loop() (%llu Aufrufe)\n", capture.size() * double(repetitions) / seconds / 1e6,
+         seconds * 1e9 / loop_calls, (unsigned long long) loop_calls);
+  return 0;
+}
+
+static int generate(const char *path, int packs, int cycles, double noise, double fake_headers) {
+  std::mt19937 random(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<uint8_t> stream;
+  for (int cycle = 0; cycle < cycles; cycle++) {
+    for (int bms = 0; bms < packs; bms++) {
+      for (const BlockDescriptor &block : BLOCKS) {
+        if (fake_headers > 0 && uniform(random) < fake_headers) {
+          stream.insert(stream.end(), {uint8_t(random() % MAX_BUS_ADDRESSES + 1), 0x04, 0xFF});
+        }
+        size_t start = stream.size();
+        stream.insert(stream.end(), {uint8_t(bms + 1), block.function, uint8_t(block.start >> 8),
+                                     uint8_t(block.start & 0xFF), uint8_t(block.count >> 8),
+                                     uint8_t(block.count & 0xFF)});
+        append_crc(&stream, start);
+
+        start = stream.size();
+        uint8_t byte_count = expected_byte_count(block.function, block.count);
+        stream.insert(stream.end(), {uint8_t(bms + 1), block.function, byte_count});
+        for (int i = 0; i < byte_count; i++) {
+          stream.push_back(uint8_t(random()));
+        }
+        append_crc(&stream, start);
+        if (uniform(random) < noise) {
+          // Verfälschtes Byte irgendwo in der Antwort
+          stream[start + 1 + random() % (stream.size() - start - 1)] ^= 0x10;
+        }
+        if (uniform(random) < noise / 5) {
+          stream.resize(start + (stream.size() - start) / 2);
+        }
+        if (uniform(random) < noise / 5) {
+          stream.push_back(uint8_t(random()));
+        }
+      }
+    }
+  }
+  FILE *file = fopen(path, "wb");
+  if (file == nullptr || fwrite(stream.data(), 1, stream.size(), file) != stream.size()) {
+    fprintf(stderr, "%s nicht schreibbar\n", path);
+    return 1;
+  }
+  fclose(file);
+  printf("%zu Byte nach %s geschrieben\n", stream.size(), path);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 2 && strcmp(argv[1], "--generate") == 0) {
+    int packs = argc > 3 ? atoi(argv[3]) : 16;
+    int cycles = argc > 4 ? atoi(argv[4]) : 2000;
+    double noise = argc > 5 ? atof(argv[5]) : 0.1;
+    double fake_headers = argc > 6 ? atof(argv[6]) : 0.0;
+    if (packs < 1 || packs > MAX_BUS_ADDRESSES || cycles < 1) {
+      fprintf(stderr, "Packs 1-%d, mindestens ein Zyklus\n", MAX_BUS_ADDRESSES);
+      return 1;
+    }
+    return generate(argv[2], packs, cycles, noise, fake_headers);
+  }
+  if (argc < 2) {
+    fprintf(stderr, "%s <Mitschnitt> [Lesegröße] [Wiederholungen] [scanner|deque]\n", argv[0]);
+    return 1;
+  }
+  std::vector<uint8_t> capture;
+  if (!read_file(argv[1], &capture) || capture.empty()) {
+    fprintf(stderr, "%s nicht lesbar oder leer\n", argv[1]);
+    return 1;
+  }
+  size_t read_size = argc > 2 ? strtoul(argv[2], nullptr, 10) : 64;
+  int repetitions = argc > 3 ? atoi(argv[3]) : 1;
+  if (read_size < 1 || read_size > FrameScanner::BUFFER_SIZE || repetitions < 1) {
+    fprintf(stderr, "Lesegröße 1-%zu, mindestens eine Wiederholung\n", FrameScanner::BUFFER_SIZE);
+    return 1;
+  }
+  if (argc > 4 && strcmp(argv[4], "deque") == 0) {
+    return replay_deque(capture, read_size, repetitions);
+  }
+
+  // Jede Wiederholung mit frischem Scanner; die Zähler stammen aus der letzten
+  FrameScannerStats stats;
+  uint32_t frames_per_block[BLOCK_COUNT]{};
+  uint64_t loop_calls = 0;
+  size_t max_delay = 0;  // Bytes, die nach dem Ende eines Frames schon da waren, bevor er geliefert wurde
+  auto begin = std::chrono::steady_clock::now();
+  for (int repetition = 0; repetition < repetitions; repetition++) {
+    FrameScanner scanner;
+    uint32_t per_block[BLOCK_COUNT]{};
+    size_t pos = 0;
+    while (pos < capture.size()) {
+      size_t space;
+      uint8_t *dest = scanner.prepare_write(&space);
+      size_t length = std::min(std::min(space, read_size), capture.size() - pos);
+      memcpy(dest, capture.data() + pos, length);
+      scanner.commit_write(length);
+      pos += length;
+      loop_calls++;
+      ModbusFrame frame;
+      while (scanner.next_frame(&frame)) {
+        max_delay = std::max(max_delay, scanner.pending());
+        if (frame.kind != FRAME_RESPONSE || !frame.paired) {
+          continue;
+        }
+        const BlockDescriptor *block = find_block(frame.data[1], frame.start, frame.count);
+        if (block != nullptr) {
+          per_block[block->id]++;
+        }
+      }
+    }
+    stats = scanner.get_stats();
+    memcpy(frames_per_block, per_block, sizeof(per_block));
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  double frames = double(stats.frames) * repetitions;
+  printf("%zu Byte, Lesegröße %zu, %d Wiederholungen\n", capture.size(), read_size, repetitions);
+  printf("Frames %u (Anfragen %u, ungepaart %u), 0x24/0x34/0x12: %u/%u/%u\n", stats.frames, stats.requests,
+         stats.unpaired_responses, frames_per_block[BLOCK_PIA], frames_per_block[BLOCK_PIB],
+         frames_per_block[BLOCK_PIC]);
+  printf("CRC-Fehler %u, Resync %u Byte, verdrängt %u Byte\n", stats.crc_errors, stats.resync_bytes,
+         stats.evicted_bytes);
+  printf("Verzögerung höchstens %zu Byte\n", max_delay);
+  printf("%.0f Frames/s, %.1f ns/Frame, %.1f MB/s, %.1f ns je loop()\n", frames / seconds, seconds * 1e9 / frames,
+         capture.size() * double(repetitions) / seconds / 1e6, seconds * 1e9 / loop_calls);
+  printf("Speicher: FrameScanner %zu Byte, Prozess höchstens %ld KiB\n", sizeof(FrameScanner), usage.ru_maxrss);
+  return 0;
+}
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Referenzdekoder und Test-Empfänger für den Binär-Upload von seplos_parser (uplink:).
+
+Format: siehe Kommentar in esphome/components/seplos_parser/seplos_uplink.h.
+
+  seplos_uplink.py decode upload.bin       # gespeicherten POST-Inhalt als JSON-Zeilen ausgeben
+  seplos_uplink.py decode capture.json     # Antwort von GET /seplos/capture?bms=N (Ereignisaufzeichnung)
+  seplos_uplink.py frames capture.json     # eine Zeile je Frame "<ms> <bms> <block> <hex>" für seplos_cells_replay
+  seplos_uplink.py serve --port 8080       # POSTs annehmen, dekodieren und ausgeben (--save DIR legt sie ab)
+
+Feldnamen und Skalierung werden wie in __init__.py aus seplos_registers.h gelesen.
+"""
+
+import argparse
+import base64
+import json
+import re
+import struct
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, HTTPServer
+from pathlib import Path
+
+REGISTERS_H = Path(__file__).resolve().parent.parent / "esphome/components/seplos_parser/seplos_registers.h"
+
+HEADER = struct.Struct("<4sBB6sIIHH")
+CHUNK_HEADER = struct.Struct("<IH")
+BLOCK_NAMES = ("pia", "pib", "pic")
+BLOCK_WORDS = (18, 26, 9)
+
+
+def load_fields():
+    header = REGISTERS_H.read_text()
+    fields = []
+    for block in ("SEPLOS_PIA_FIELDS", "SEPLOS_PIB_FIELDS"):
+        body = header.split(f"#define {block}(F)", 1)[1].split("\n\n", 1)[0]
+        row = r"F\((\w+),\s*(\w+),\s*(\d+),\s*(\w+),\s*([-\d.]+)f,\s*([-\d.]+)f"
+        fields.append(
+            [
+                # Wortindex = (Byte-Offset - 3) / 2
+                ((int(offset) - 3) // 2, name, signedness == "SIGNED", float(divisor), float(add))
+                for _, name, offset, signedness, divisor, add in re.findall(row, body)
+            ]
+        )
+    return fields
+
+
+FIELDS = load_fields()
+
+
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def decode(payload):
+    """Liefert (Kopf, Einträge); Einträge enthalten die Rohworte und, für 0x24/0x34, die skalierten Felder."""
+    magic, version, bms_count, mac, sent_ms, unix_time, chunk_count, dropped = HEADER.unpack_from(payload, 0)
+    if magic != b"SPL1" or version not in (1, 2):
+        raise ValueError(f"unbekanntes Format {magic!r} v{version}")
+    head = {
+        "bms_count": bms_count,
+        "mac": mac.hex(":"),
+        "sent_ms": sent_ms,
+        "unix_time": unix_time or None,
+        "chunks": chunk_count,
+        "dropped_chunks": dropped,
+    }
+    records = []
+    pos = HEADER.size
+    for _ in range(chunk_count):
+        base_ms, length = CHUNK_HEADER.unpack_from(payload, pos)
+        pos += CHUNK_HEADER.size
+        end = pos + length
+        previous = {}
+        timestamp = base_ms
+        while pos < end:
+            tag = payload[pos]
+            pos += 1
+            # Version 2: BMS-Index Bits 4-5 in Bits 6-7, bei Version 1 immer 0
+            bms, block = (tag & 0x0F) | (tag >> 6) << 4, (tag >> 4) & 0x03
+            dt, pos = read_varint(payload, pos)
+            mask, pos = read_varint(payload, pos)
+            timestamp = (timestamp + dt) & 0xFFFFFFFF
+            words = list(previous.get((bms, block), [0] * BLOCK_WORDS[block]))
+            for i in range(BLOCK_WORDS[block]):
+                if mask & (1 << i):
+                    zigzag, pos = read_varint(payload, pos)
+                    delta = (zigzag >> 1) ^ -(zigzag & 1)
+                    words[i] = (words[i] + delta) & 0xFFFF
+            previous[(bms, block)] = words
+            record = {"bms": bms, "block": BLOCK_NAMES[block], "ms": timestamp, "words": words}
+            # millis() läuft nach 49 Tagen über; Abstand zum Sendezeitpunkt modulo 2^32
+            if unix_time:
+                record["time"] = unix_time - ((sent_ms - timestamp) & 0xFFFFFFFF) / 1000.0
+            if block < len(FIELDS):
+                for index, name, signed, divisor, add in FIELDS[block]:
+                    raw = words[index]
+                    if signed and raw >= 0x8000:
+                        raw -= 0x10000
+                    record[name] = round(raw / divisor + add, 4)
+            records.append(record)
+        if pos != end:
+            raise ValueError("Abschnittslänge passt nicht zu den Einträgen")
+    return head, records
+
+
+def print_frames(payload, out=sys.stdout):
+    if payload[:1] == b"{":
+        payload = base64.b64decode(json.loads(payload)["payload"])
+    _, records = decode(payload)
+    for record in records:
+        data = "".join(f"{word:04x}" for word in record["words"])
+        print(record["ms"], record["bms"], record["block"], data, file=out)
+
+
+def print_payload(payload, out=sys.stdout):
+    if payload[:1] == b"{":
+        # Ereignisaufzeichnung aus dem web_server: Nutzdaten Base64-kodiert in JSON
+        capture = json.loads(payload)
+        payload = base64.b64decode(capture.pop("payload"))
+        print(json.dumps({"capture": capture}), file=out)
+    head, records = decode(payload)
+    print(json.dumps(head), file=out)
+    for record in records:
+        print(json.dumps(record), file=out)
+    return head, records
+
+
+class Receiver(BaseHTTPRequestHandler):
+    save_dir = None
+
+    def do_POST(self):
+        payload = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+        try:
+            head, records = print_payload(payload)
+        except (ValueError, IndexError, struct.error) as error:
+            self.send_response(400)
+            self.end_headers()
+            self.wfile.write(str(error).encode())
+            return
+        if self.save_dir is not None:
+            name = f"{head['mac'].replace(':', '')}-{int(time.time())}.bin"
+            (self.save_dir / name).write_bytes(payload)
+        print(
+            f"# {len(payload)} Byte, {len(records)} Einträge, api_key={self.headers.get('X-Api-Key')!r}",
+            file=sys.stderr,
+        )
+        # Eingefrorene Ereignisaufzeichnung: bms=N;trigger_ms=...;bits=<18 Alarm-Bytes hex>
+        if "X-Seplos-Capture" in self.headers:
+            print(f"# Ereignisaufzeichnung {self.headers['X-Seplos-Capture']}", file=sys.stderr)
+        self.send_response(204)
+        self.end_headers()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+    decode_cmd = commands.add_parser("decode")
+    decode_cmd.add_argument("file", type=Path)
+    frames_cmd = commands.add_parser("frames")
+    frames_cmd.add_argument("file", type=Path)
+    serve_cmd = commands.add_parser("serve")
+    serve_cmd.add_argument("--port", type=int, default=8080)
+    serve_cmd.add_argument("--save", type=Path)
+    args = parser.parse_args()
+
+    if args.command == "decode":
+        print_payload(args.file.read_bytes())
+    elif args.command == "frames":
+        print_frames(args.file.read_bytes())
+    else:
+        Receiver.save_dir = args.save
+        HTTPServer(("", args.port), Receiver).serve_forever()
+
+
+if __name__ == "__main__":
+    main()